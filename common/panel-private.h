@@ -64,6 +64,13 @@
  * without asking the user what to do */
 #define PANEL_PLUGIN_AUTO_RESTART (60)
 
+/* decoded background image shared by the panel with the wrapper plugins,
+ * a header of 4 guint32 values (magic, width, height and stride) followed by
+ * the CAIRO_FORMAT_ARGB32 pixel data */
+#define PANEL_BACKGROUND_CACHE_MAGIC  (0x58504247)
+#define PANEL_BACKGROUND_CACHE_HEADER (4 * sizeof (guint32))
+#define PANEL_BACKGROUND_CACHE_PREFIX "xfce4-panel-background-"
+
 /* integer swap functions */
 #define SWAP_INTEGER(a,b) G_STMT_START { gint swp = a; a = b; b = swp; } G_STMT_END
 #define TRANSPOSE_AREA(area) G_STMT_START { SWAP_INTEGER (area.width, area.height); \
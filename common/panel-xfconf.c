@@ -28,6 +28,51 @@
 
 
 
+/* delay before changed object properties are written to xfconf, so
+ * continuous changes (e.g. a slider) result in a few writes only */
+#define PANEL_PROPERTIES_FLUSH_DELAY (250)
+
+
+
+typedef struct _PanelPropertyBinding PanelPropertyBinding;
+struct _PanelPropertyBinding
+{
+  XfconfChannel *channel;
+  GObject       *object;
+
+  gchar         *xfconf_property;
+  const gchar   *object_property;
+  GType          type;
+
+  gulong         notify_id;
+  gulong         changed_id;
+
+  /* value waiting to be written to xfconf, unset if there is none */
+  GValue         pending;
+};
+
+
+
+static void panel_properties_object_disposed (gpointer  data,
+                                              GObject  *where_the_object_was);
+
+
+
+/* bindings with a pending value and the timeout to write them */
+static GSList     *pending_bindings = NULL;
+static guint       pending_flush_id = 0;
+
+/* snapshot of the entire channel, used while the panels are
+ * created at startup instead of querying each property */
+static GHashTable    *snapshot_properties = NULL;
+static XfconfChannel *snapshot_channel = NULL;
+static gulong         snapshot_changed_id = 0;
+static guint          snapshot_idle_id = 0;
+
+static GQuark      bindings_quark = 0;
+
+
+
 static void
 panel_properties_store_value (XfconfChannel *channel,
                               const gchar   *xfconf_property,
@@ -83,6 +128,238 @@ panel_properties_store_value (XfconfChannel *channel,
 
 
 
+static void
+panel_properties_snapshot_changed (XfconfChannel *channel,
+                                   const gchar   *xfconf_property,
+                                   const GValue  *value)
+{
+  GValue *copy;
+
+  panel_return_if_fail (snapshot_channel == channel);
+  panel_return_if_fail (snapshot_properties != NULL);
+
+  /* keep the snapshot in sync with changes during startup */
+  if (G_IS_VALUE (value))
+    {
+      copy = g_new0 (GValue, 1);
+      g_value_init (copy, G_VALUE_TYPE (value));
+      g_value_copy (value, copy);
+      g_hash_table_replace (snapshot_properties, g_strdup (xfconf_property), copy);
+    }
+  else
+    {
+      g_hash_table_remove (snapshot_properties, xfconf_property);
+    }
+}
+
+
+
+static gboolean
+panel_properties_snapshot_idle (gpointer user_data)
+{
+  snapshot_idle_id = 0;
+  panel_properties_snapshot_free ();
+
+  return FALSE;
+}
+
+
+
+static void
+panel_properties_binding_flush (PanelPropertyBinding *binding)
+{
+  if (!G_IS_VALUE (&binding->pending))
+    return;
+
+  pending_bindings = g_slist_remove (pending_bindings, binding);
+
+  xfconf_channel_set_property (binding->channel, binding->xfconf_property,
+                               &binding->pending);
+  g_value_unset (&binding->pending);
+}
+
+
+
+static gboolean
+panel_properties_flush (gpointer user_data)
+{
+  /* write all pending values, only the last value of each property
+   * is sent to xfconf */
+  while (pending_bindings != NULL)
+    panel_properties_binding_flush (pending_bindings->data);
+
+  return FALSE;
+}
+
+
+
+static void
+panel_properties_flush_destroyed (gpointer user_data)
+{
+  pending_flush_id = 0;
+}
+
+
+
+static void
+panel_properties_object_notify (GObject              *object,
+                                GParamSpec           *pspec,
+                                PanelPropertyBinding *binding)
+{
+  panel_return_if_fail (binding->object == object);
+
+  /* remember the new value and queue it for writing */
+  if (G_IS_VALUE (&binding->pending))
+    g_value_unset (&binding->pending);
+  else
+    pending_bindings = g_slist_append (pending_bindings, binding);
+
+  g_value_init (&binding->pending, binding->type);
+  g_object_get_property (object, binding->object_property, &binding->pending);
+
+  if (pending_flush_id == 0)
+    pending_flush_id = g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE,
+                                           PANEL_PROPERTIES_FLUSH_DELAY,
+                                           panel_properties_flush, NULL,
+                                           panel_properties_flush_destroyed);
+}
+
+
+
+static void
+panel_properties_object_set (PanelPropertyBinding *binding,
+                             const GValue         *value)
+{
+  GValue      dest = { 0, };
+  GValue      current = { 0, };
+  GParamSpec *pspec;
+
+  pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (binding->object),
+                                        binding->object_property);
+  panel_return_if_fail (pspec != NULL);
+
+  g_value_init (&dest, binding->type);
+  if (g_value_transform (value, &dest))
+    {
+      /* only set the object property if the value is different */
+      g_value_init (&current, binding->type);
+      g_object_get_property (binding->object, binding->object_property, &current);
+
+      if (g_param_values_cmp (pspec, &current, &dest) != 0)
+        {
+          g_signal_handler_block (binding->object, binding->notify_id);
+          g_object_set_property (binding->object, binding->object_property, &dest);
+          g_signal_handler_unblock (binding->object, binding->notify_id);
+        }
+
+      g_value_unset (&current);
+    }
+
+  g_value_unset (&dest);
+}
+
+
+
+static void
+panel_properties_channel_changed (XfconfChannel        *channel,
+                                  const gchar          *xfconf_property,
+                                  const GValue         *value,
+                                  PanelPropertyBinding *binding)
+{
+  /* a local change that is not written yet wins */
+  if (G_IS_VALUE (&binding->pending)
+      || !G_IS_VALUE (value))
+    return;
+
+  panel_properties_object_set (binding, value);
+}
+
+
+
+static void
+panel_properties_binding_new (XfconfChannel *channel,
+                              const gchar   *xfconf_property,
+                              GType          xfconf_property_type,
+                              GObject       *object,
+                              const gchar   *object_property,
+                              gboolean       save_property)
+{
+  PanelPropertyBinding *binding;
+  GSList               *bindings;
+  gchar                *signal_name;
+  GValue                value = { 0, };
+
+  binding = g_slice_new0 (PanelPropertyBinding);
+  binding->channel = g_object_ref (G_OBJECT (channel));
+  binding->object = object;
+  binding->xfconf_property = g_strdup (xfconf_property);
+  binding->object_property = g_intern_string (object_property);
+  binding->type = xfconf_property_type;
+
+  bindings = g_object_get_qdata (object, bindings_quark);
+  g_object_set_qdata (object, bindings_quark, g_slist_prepend (bindings, binding));
+
+  signal_name = g_strconcat ("notify::", object_property, NULL);
+  binding->notify_id = g_signal_connect (G_OBJECT (object), signal_name,
+      G_CALLBACK (panel_properties_object_notify), binding);
+  g_free (signal_name);
+
+  signal_name = g_strconcat ("property-changed::", xfconf_property, NULL);
+  binding->changed_id = g_signal_connect (G_OBJECT (channel), signal_name,
+      G_CALLBACK (panel_properties_channel_changed), binding);
+  g_free (signal_name);
+
+  if (save_property)
+    {
+      /* store the object value in xfconf right away, only later
+       * changes are delayed */
+      panel_properties_store_value (channel, xfconf_property, xfconf_property_type,
+                                    object, object_property);
+    }
+  else if (panel_properties_snapshot_get (channel, xfconf_property, &value))
+    {
+      /* update the object with the value in xfconf */
+      panel_properties_object_set (binding, &value);
+      g_value_unset (&value);
+    }
+}
+
+
+
+static void
+panel_properties_binding_free (PanelPropertyBinding *binding,
+                               gboolean              disconnect_object)
+{
+  panel_properties_binding_flush (binding);
+
+  if (disconnect_object)
+    g_signal_handler_disconnect (binding->object, binding->notify_id);
+  g_signal_handler_disconnect (binding->channel, binding->changed_id);
+  g_object_unref (G_OBJECT (binding->channel));
+
+  g_free (binding->xfconf_property);
+  g_slice_free (PanelPropertyBinding, binding);
+}
+
+
+
+static void
+panel_properties_object_disposed (gpointer  data,
+                                  GObject  *where_the_object_was)
+{
+  GSList *bindings, *li;
+
+  bindings = g_object_get_qdata (where_the_object_was, bindings_quark);
+  for (li = bindings; li != NULL; li = li->next)
+    if (li->data != NULL)
+      panel_properties_binding_free (li->data, FALSE);
+  g_slist_free (bindings);
+
+  g_object_set_qdata (where_the_object_was, bindings_quark, NULL);
+}
+
+
+
 XfconfChannel *
 panel_properties_get_channel (GObject *object_for_weak_ref)
 {
@@ -121,6 +398,17 @@ panel_properties_bind (XfconfChannel       *channel,
   panel_return_if_fail (property_base != NULL && *property_base == '/');
   panel_return_if_fail (properties != NULL);
 
+  if (G_UNLIKELY (bindings_quark == 0))
+    bindings_quark = g_quark_from_static_string ("panel-properties-bindings");
+
+  /* take a weak ref to write the pending values before the object is
+   * gone, prior to the one that might shut down xfconf */
+  if (g_object_get_qdata (object, bindings_quark) == NULL)
+    {
+      g_object_weak_ref (object, panel_properties_object_disposed, NULL);
+      g_object_set_qdata (object, bindings_quark, g_slist_alloc ());
+    }
+
   if (G_LIKELY (channel == NULL))
     channel = panel_properties_get_channel (object);
   panel_return_if_fail (XFCONF_IS_CHANNEL (channel));
@@ -130,13 +418,18 @@ panel_properties_bind (XfconfChannel       *channel,
     {
       property = g_strconcat (property_base, "/", prop->property, NULL);
 
-      if (save_properties)
-        panel_properties_store_value (channel, property, prop->type, object, prop->property);
-
       if (G_LIKELY (prop->type != GDK_TYPE_RGBA))
-        xfconf_g_property_bind (channel, property, prop->type, object, prop->property);
+        {
+          panel_properties_binding_new (channel, property, prop->type,
+                                        object, prop->property, save_properties);
+        }
       else
-        xfconf_g_property_bind_gdkrgba (channel, property, object, prop->property);
+        {
+          if (save_properties)
+            panel_properties_store_value (channel, property, prop->type, object, prop->property);
+
+          xfconf_g_property_bind_gdkrgba (channel, property, object, prop->property);
+        }
 
       g_free (property);
     }
@@ -144,9 +437,105 @@ panel_properties_bind (XfconfChannel       *channel,
 
 
 
+void
+panel_properties_snapshot_load (XfconfChannel *channel)
+{
+  panel_return_if_fail (XFCONF_IS_CHANNEL (channel));
+
+  /* the snapshot is kept up-to-date while it is loaded */
+  if (snapshot_properties != NULL
+      && snapshot_channel == channel)
+    return;
+
+  panel_properties_snapshot_free ();
+
+  /* fetch all the properties in the channel in one call */
+  snapshot_properties = xfconf_channel_get_properties (channel, NULL);
+  if (G_UNLIKELY (snapshot_properties == NULL))
+    return;
+
+  snapshot_channel = g_object_ref (G_OBJECT (channel));
+  snapshot_changed_id = g_signal_connect (G_OBJECT (channel), "property-changed",
+      G_CALLBACK (panel_properties_snapshot_changed), NULL);
+
+  /* the snapshot is only used during startup, drop it once all the
+   * plugins have been constructed */
+  snapshot_idle_id = g_idle_add_full (G_PRIORITY_LOW, panel_properties_snapshot_idle,
+                                      NULL, NULL);
+}
+
+
+
+gboolean
+panel_properties_snapshot_get (XfconfChannel *channel,
+                               const gchar   *xfconf_property,
+                               GValue        *value)
+{
+  const GValue *snapshot_value;
+
+  panel_return_val_if_fail (XFCONF_IS_CHANNEL (channel), FALSE);
+  panel_return_val_if_fail (xfconf_property != NULL, FALSE);
+  panel_return_val_if_fail (value != NULL && !G_IS_VALUE (value), FALSE);
+
+  if (snapshot_properties == NULL
+      || snapshot_channel != channel)
+    return xfconf_channel_get_property (channel, xfconf_property, value);
+
+  /* the snapshot contains all the properties in the channel, so
+   * missing properties are not set in xfconf either */
+  snapshot_value = g_hash_table_lookup (snapshot_properties, xfconf_property);
+  if (snapshot_value == NULL)
+    return FALSE;
+
+  g_value_init (value, G_VALUE_TYPE (snapshot_value));
+  g_value_copy (snapshot_value, value);
+
+  return TRUE;
+}
+
+
+
+void
+panel_properties_snapshot_free (void)
+{
+  if (snapshot_properties == NULL)
+    return;
+
+  if (snapshot_idle_id != 0)
+    g_source_remove (snapshot_idle_id);
+  snapshot_idle_id = 0;
+
+  g_signal_handler_disconnect (snapshot_channel, snapshot_changed_id);
+  g_object_unref (G_OBJECT (snapshot_channel));
+  g_hash_table_destroy (snapshot_properties);
+
+  snapshot_properties = NULL;
+  snapshot_channel = NULL;
+  snapshot_changed_id = 0;
+}
+
+
+
 void
 panel_properties_unbind (GObject *object)
 {
+  GSList *bindings, *li;
+
+  panel_return_if_fail (G_IS_OBJECT (object));
+
+  /* write the pending values and release the bindings */
+  bindings = g_object_get_qdata (object, bindings_quark);
+  if (bindings != NULL)
+    {
+      for (li = bindings; li != NULL; li = li->next)
+        if (li->data != NULL)
+          panel_properties_binding_free (li->data, TRUE);
+      g_slist_free (bindings);
+
+      g_object_set_qdata (object, bindings_quark, NULL);
+      g_object_weak_unref (object, panel_properties_object_disposed, NULL);
+    }
+
   xfconf_g_property_unbind_all (object);
 }
 
@@ -44,6 +44,14 @@ void           panel_properties_bind                 (XfconfChannel       *chann
 
 void           panel_properties_unbind               (GObject             *object);
 
+void           panel_properties_snapshot_load        (XfconfChannel       *channel);
+
+gboolean       panel_properties_snapshot_get         (XfconfChannel       *channel,
+                                                      const gchar         *xfconf_property,
+                                                      GValue              *value);
+
+void           panel_properties_snapshot_free        (void);
+
 GType          panel_properties_value_array_get_type (void) G_GNUC_CONST;
 
 #endif /* !__PANEL_XFCONF_H__ */
@@ -62,6 +62,16 @@
 /* design limit for the panel, to reduce the uncached pixbuf size */
 #define MAX_PIXBUF_SIZE (128)
 
+/* load icons asynchronously when the icon info api is available */
+#if GTK_CHECK_VERSION (3, 10, 0)
+#define ASYNC_ICON_LOADING
+#endif
+
+/* render cairo surfaces at the device scale of the widget */
+#if GTK_CHECK_VERSION (3, 10, 0)
+#define SURFACE_RENDERING
+#endif
+
 #define xfce_panel_image_unref_null(obj)   G_STMT_START { if ((obj) != NULL) \
                                              { \
                                                g_object_unref (G_OBJECT (obj)); \
@@ -75,9 +85,14 @@ struct _XfcePanelImagePrivate
   /* pixbuf set by the user */
   GdkPixbuf *pixbuf;
 
-  /* internal cached pixbuf (resized) */
+  /* internal cached pixbuf (resized), in device pixels */
   GdkPixbuf *cache;
 
+#ifdef SURFACE_RENDERING
+  /* surface of the cached pixbuf, created once for drawing */
+  cairo_surface_t *surface;
+#endif
+
   /* source name */
   gchar     *source;
 
@@ -91,10 +106,43 @@ struct _XfcePanelImagePrivate
   gint       width;
   gint       height;
 
+  /* scale factor the cache was loaded for */
+  gint       scale;
+
   /* idle load timeout */
   guint      idle_load_id;
+
+#ifdef ASYNC_ICON_LOADING
+  /* pending asynchronous load this image waits for */
+  struct _XfcePanelImageRequest *request;
+#endif
 };
 
+#ifdef ASYNC_ICON_LOADING
+typedef struct _XfcePanelImageRequest XfcePanelImageRequest;
+struct _XfcePanelImageRequest
+{
+  /* key in the pixbuf cache */
+  gchar        *key;
+
+  /* icon source and theme to load from */
+  gchar        *source;
+  GtkIconTheme *icon_theme;
+  gint          dest_width;
+  gint          dest_height;
+  gint          scale;
+
+  /* cache generation the request was started in */
+  guint         generation;
+
+  /* images waiting for the result */
+  GSList       *images;
+
+  /* cancelled when there are no images waiting anymore */
+  GCancellable *cancellable;
+};
+#endif
+
 enum
 {
   PROP_0,
@@ -142,9 +190,33 @@ static void       xfce_panel_image_style_set            (GtkWidget       *widget
 #endif
 static gboolean   xfce_panel_image_load                 (gpointer         data);
 static void       xfce_panel_image_load_destroy         (gpointer         data);
+static void       xfce_panel_image_cache_free           (XfcePanelImage  *image);
 static GdkPixbuf *xfce_panel_image_scale_pixbuf         (GdkPixbuf       *source,
                                                          gint             dest_width,
                                                          gint             dest_height);
+static GdkPixbuf *xfce_panel_image_scale_to_device      (GdkPixbuf       *source,
+                                                         gint             dest_width,
+                                                         gint             dest_height,
+                                                         gint             scale);
+static gchar     *xfce_panel_image_cache_key            (const gchar     *source,
+                                                         GtkIconTheme    *icon_theme,
+                                                         gint             dest_width,
+                                                         gint             dest_height,
+                                                         gint             scale);
+static GdkPixbuf *xfce_panel_image_cache_lookup         (const gchar     *key);
+static void       xfce_panel_image_cache_insert         (const gchar     *key,
+                                                         GdkPixbuf       *pixbuf,
+                                                         GtkIconTheme    *icon_theme);
+static void       xfce_panel_image_cache_watch_theme    (GtkIconTheme    *icon_theme);
+#ifdef ASYNC_ICON_LOADING
+static gboolean   xfce_panel_image_request              (XfcePanelImage  *image,
+                                                         const gchar     *key,
+                                                         GtkIconTheme    *icon_theme,
+                                                         gint             dest_width,
+                                                         gint             dest_height,
+                                                         gint             scale);
+static void       xfce_panel_image_request_detach       (XfcePanelImage  *image);
+#endif
 
 
 
@@ -152,6 +224,24 @@ G_DEFINE_TYPE (XfcePanelImage, xfce_panel_image, GTK_TYPE_WIDGET)
 
 
 
+/* process-wide cache of loaded icons, shared by all the images so
+ * identical icons are only loaded once. the cache does not own the
+ * pixbufs, entries are removed when the last user releases it */
+static GHashTable *pixbuf_cache = NULL;
+
+#ifdef ASYNC_ICON_LOADING
+/* pending asynchronous loads, with the cache key as key */
+static GHashTable *pixbuf_requests = NULL;
+#endif
+
+/* quark to mark icon themes we monitor for changes */
+static GQuark      pixbuf_cache_theme_quark = 0;
+
+/* bumped on theme changes, results of older loads are not cached */
+static guint       pixbuf_cache_generation = 0;
+
+
+
 static void
 xfce_panel_image_class_init (XfcePanelImageClass *klass)
 {
@@ -232,7 +322,14 @@ xfce_panel_image_init (XfcePanelImage *image)
   image->priv->size = -1;
   image->priv->width = -1;
   image->priv->height = -1;
+  image->priv->scale = 1;
   image->priv->force_icon_sizes = FALSE;
+#ifdef SURFACE_RENDERING
+  image->priv->surface = NULL;
+#endif
+#ifdef ASYNC_ICON_LOADING
+  image->priv->request = NULL;
+#endif
 }
 
 
@@ -460,28 +557,36 @@ xfce_panel_image_size_allocate (GtkWidget     *widget,
                                 GtkAllocation *allocation)
 {
   XfcePanelImagePrivate *priv = XFCE_PANEL_IMAGE (widget)->priv;
+  gint                   scale = 1;
 
   gtk_widget_set_allocation (widget, allocation);
 
-  /* check if the available size changed */
+#ifdef SURFACE_RENDERING
+  scale = gtk_widget_get_scale_factor (widget);
+#endif
+
+  /* check if the available size or scale changed */
   if ((priv->pixbuf != NULL || priv->source != NULL)
       && allocation->width > 0
       && allocation->height > 0
       && (allocation->width != priv->width
-      || allocation->height != priv->height))
+      || allocation->height != priv->height
+      || scale != priv->scale))
     {
       /* store the new size */
       priv->width = allocation->width;
       priv->height = allocation->height;
+      priv->scale = scale;
 
       /* free cache */
-      xfce_panel_image_unref_null (priv->cache);
+      xfce_panel_image_cache_free (XFCE_PANEL_IMAGE (widget));
 
       if (priv->pixbuf == NULL)
         {
           /* delay icon loading */
-          priv->idle_load_id = gdk_threads_add_idle_full (G_PRIORITY_DEFAULT_IDLE, xfce_panel_image_load,
-                                                          widget, xfce_panel_image_load_destroy);
+          if (priv->idle_load_id == 0)
+            priv->idle_load_id = gdk_threads_add_idle_full (G_PRIORITY_DEFAULT_IDLE, xfce_panel_image_load,
+                                                            widget, xfce_panel_image_load_destroy);
         }
       else
         {
@@ -501,11 +606,34 @@ xfce_panel_image_draw (GtkWidget *widget,
   XfcePanelImagePrivate *priv = XFCE_PANEL_IMAGE (widget)->priv;
   gint                   source_width, source_height;
   gint                   dest_x, dest_y;
+#ifndef SURFACE_RENDERING
   GtkIconSource         *source;
   GdkPixbuf             *rendered = NULL;
+#endif
   GdkPixbuf             *pixbuf = priv->cache;
   GtkStyleContext       *context;
 
+#ifdef SURFACE_RENDERING
+  if (G_LIKELY (pixbuf != NULL))
+    {
+      /* convert the pixbuf once, so drawing is a single paint */
+      if (G_UNLIKELY (priv->surface == NULL))
+        priv->surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, priv->scale,
+                                                              gtk_widget_get_window (widget));
+
+      /* size of the surface in logical pixels */
+      source_width = gdk_pixbuf_get_width (pixbuf) / priv->scale;
+      source_height = gdk_pixbuf_get_height (pixbuf) / priv->scale;
+
+      /* position */
+      dest_x = (priv->width - source_width) / 2;
+      dest_y = (priv->height - source_height) / 2;
+
+      /* draw the icon, the style takes care of the insensitive effect */
+      context = gtk_widget_get_style_context (widget);
+      gtk_render_icon_surface (context, cr, priv->surface, dest_x, dest_y);
+    }
+#else
   if (G_LIKELY (pixbuf != NULL))
     {
       /* get the size of the cache pixbuf */
@@ -535,6 +663,7 @@ xfce_panel_image_draw (GtkWidget *widget,
       if (rendered != NULL)
         g_object_unref (G_OBJECT (rendered));
     }
+#endif
 
   return FALSE;
 }
@@ -679,6 +808,13 @@ xfce_panel_image_load (gpointer data)
   GdkScreen             *screen;
   GtkIconTheme          *icon_theme = NULL;
   gint                   dest_w, dest_h;
+  gint                   scale = priv->scale;
+  gchar                 *key;
+
+#ifdef ASYNC_ICON_LOADING
+  /* a pending load for the previous size or source is not needed anymore */
+  xfce_panel_image_request_detach (XFCE_PANEL_IMAGE (data));
+#endif
 
   dest_w = priv->width;
   dest_h = priv->height;
@@ -707,7 +843,7 @@ xfce_panel_image_load (gpointer data)
       if (G_LIKELY (pixbuf != NULL))
         {
           /* scale the icon to the correct size */
-          priv->cache = xfce_panel_image_scale_pixbuf (pixbuf, dest_w, dest_h);
+          priv->cache = xfce_panel_image_scale_to_device (pixbuf, dest_w, dest_h, scale);
           g_object_unref (G_OBJECT (pixbuf));
         }
     }
@@ -716,8 +852,39 @@ xfce_panel_image_load (gpointer data)
       screen = gtk_widget_get_screen (GTK_WIDGET (data));
       if (G_LIKELY (screen != NULL))
         icon_theme = gtk_icon_theme_get_for_screen (screen);
+      else
+        icon_theme = gtk_icon_theme_get_default ();
+
+      /* check if another image already loaded this icon */
+      key = xfce_panel_image_cache_key (priv->source, icon_theme, dest_w, dest_h, scale);
+      priv->cache = xfce_panel_image_cache_lookup (key);
+
+      if (priv->cache == NULL)
+        {
+#ifdef ASYNC_ICON_LOADING
+          /* start or join an asynchronous load */
+          if (xfce_panel_image_request (XFCE_PANEL_IMAGE (data), key,
+                                        icon_theme, dest_w, dest_h, scale))
+            {
+              g_free (key);
+              return FALSE;
+            }
+#endif
+
+          pixbuf = xfce_panel_pixbuf_from_source_at_size (priv->source, icon_theme,
+                                                          dest_w * scale, dest_h * scale);
+          if (G_LIKELY (pixbuf != NULL))
+            {
+              /* the fallbacks might only have found a smaller icon */
+              priv->cache = xfce_panel_image_scale_to_device (pixbuf, dest_w, dest_h, scale);
+              g_object_unref (G_OBJECT (pixbuf));
+
+              if (G_LIKELY (priv->cache != NULL))
+                xfce_panel_image_cache_insert (key, priv->cache, icon_theme);
+            }
+        }
 
-      priv->cache = xfce_panel_pixbuf_from_source_at_size (priv->source, icon_theme, dest_w, dest_h);
+      g_free (key);
     }
 
   if (G_LIKELY (priv->cache != NULL))
@@ -736,6 +903,24 @@ xfce_panel_image_load_destroy (gpointer data)
 
 
 
+static void
+xfce_panel_image_cache_free (XfcePanelImage *image)
+{
+  XfcePanelImagePrivate *priv = image->priv;
+
+  xfce_panel_image_unref_null (priv->cache);
+
+#ifdef SURFACE_RENDERING
+  if (priv->surface != NULL)
+    {
+      cairo_surface_destroy (priv->surface);
+      priv->surface = NULL;
+    }
+#endif
+}
+
+
+
 static GdkPixbuf *
 xfce_panel_image_scale_pixbuf (GdkPixbuf *source,
                                gint       dest_width,
@@ -773,6 +958,385 @@ xfce_panel_image_scale_pixbuf (GdkPixbuf *source,
 
 
 
+static GdkPixbuf *
+xfce_panel_image_scale_to_device (GdkPixbuf *source,
+                                  gint       dest_width,
+                                  gint       dest_height,
+                                  gint       scale)
+{
+  GdkPixbuf *pixbuf;
+  gint       width, height;
+
+  panel_return_val_if_fail (GDK_IS_PIXBUF (source), NULL);
+
+  /* a pixbuf that fills the size in device pixels was loaded for
+   * this scale and is drawn with the device scale */
+  pixbuf = xfce_panel_image_scale_pixbuf (source, dest_width * scale, dest_height * scale);
+  if (scale == 1 || pixbuf == NULL)
+    return pixbuf;
+
+  if (gdk_pixbuf_get_width (pixbuf) == dest_width * scale
+      || gdk_pixbuf_get_height (pixbuf) == dest_height * scale)
+    return pixbuf;
+
+  g_object_unref (G_OBJECT (pixbuf));
+
+  /* smaller pixbufs are 1x data, keep the size they have at scale 1
+   * and upscale them to the device pixels of that size */
+  pixbuf = xfce_panel_image_scale_pixbuf (source, dest_width, dest_height);
+  if (G_UNLIKELY (pixbuf == NULL))
+    return NULL;
+
+  width = gdk_pixbuf_get_width (pixbuf) * scale;
+  height = gdk_pixbuf_get_height (pixbuf) * scale;
+  g_object_unref (G_OBJECT (pixbuf));
+
+  return gdk_pixbuf_scale_simple (source, width, height, GDK_INTERP_BILINEAR);
+}
+
+
+
+static gchar *
+xfce_panel_image_cache_key (const gchar  *source,
+                            GtkIconTheme *icon_theme,
+                            gint          dest_width,
+                            gint          dest_height,
+                            gint          scale)
+{
+  /* the theme is irrelevant for files */
+  if (g_path_is_absolute (source))
+    icon_theme = NULL;
+
+  return g_strdup_printf ("%p:%dx%d@%d:%s", icon_theme, dest_width,
+                          dest_height, scale, source);
+}
+
+
+
+static GdkPixbuf *
+xfce_panel_image_cache_lookup (const gchar *key)
+{
+  GdkPixbuf *pixbuf;
+
+  if (pixbuf_cache == NULL)
+    return NULL;
+
+  pixbuf = g_hash_table_lookup (pixbuf_cache, key);
+  if (pixbuf != NULL)
+    return g_object_ref (G_OBJECT (pixbuf));
+
+  return NULL;
+}
+
+
+
+static void
+xfce_panel_image_cache_weak_notify (gpointer  data,
+                                    GObject  *where_the_object_was)
+{
+  const gchar *key = data;
+
+  /* the key is owned by the table, the pixbuf might also be stored
+   * under other keys, so only remove this entry */
+  if (g_hash_table_lookup (pixbuf_cache, key) == (gpointer) where_the_object_was)
+    g_hash_table_remove (pixbuf_cache, key);
+}
+
+
+
+static void
+xfce_panel_image_cache_theme_changed (GtkIconTheme *icon_theme,
+                                      gpointer      user_data)
+{
+  GHashTableIter iter;
+  gpointer       key, pixbuf;
+
+  /* loads that are still pending return icons of the old theme, don't
+   * let them into the cache and don't let new loads join them */
+  pixbuf_cache_generation++;
+#ifdef ASYNC_ICON_LOADING
+  if (pixbuf_requests != NULL)
+    g_hash_table_remove_all (pixbuf_requests);
+#endif
+
+  if (pixbuf_cache == NULL)
+    return;
+
+  /* drop all the cached icons, images reload their icons when the
+   * style is updated after a theme change */
+  g_hash_table_iter_init (&iter, pixbuf_cache);
+  while (g_hash_table_iter_next (&iter, &key, &pixbuf))
+    g_object_weak_unref (G_OBJECT (pixbuf), xfce_panel_image_cache_weak_notify, key);
+
+  g_hash_table_remove_all (pixbuf_cache);
+}
+
+
+
+static void
+xfce_panel_image_cache_insert (const gchar  *key,
+                               GdkPixbuf    *pixbuf,
+                               GtkIconTheme *icon_theme)
+{
+  gchar *key_copy;
+
+  panel_return_if_fail (GDK_IS_PIXBUF (pixbuf));
+
+  if (G_UNLIKELY (pixbuf_cache == NULL))
+    pixbuf_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  if (g_hash_table_lookup (pixbuf_cache, key) != NULL)
+    return;
+
+  key_copy = g_strdup (key);
+  g_hash_table_insert (pixbuf_cache, key_copy, pixbuf);
+  g_object_weak_ref (G_OBJECT (pixbuf), xfce_panel_image_cache_weak_notify, key_copy);
+
+  xfce_panel_image_cache_watch_theme (icon_theme);
+}
+
+
+
+static void
+xfce_panel_image_cache_watch_theme (GtkIconTheme *icon_theme)
+{
+  if (G_UNLIKELY (pixbuf_cache_theme_quark == 0))
+    pixbuf_cache_theme_quark = g_quark_from_static_string ("xfce-panel-image-cache");
+
+  /* watch the theme for changes, themes are never destroyed so
+   * we can connect once for the lifetime of the process */
+  if (icon_theme != NULL
+      && g_object_get_qdata (G_OBJECT (icon_theme), pixbuf_cache_theme_quark) == NULL)
+    {
+      g_signal_connect (G_OBJECT (icon_theme), "changed",
+          G_CALLBACK (xfce_panel_image_cache_theme_changed), NULL);
+      g_object_set_qdata (G_OBJECT (icon_theme), pixbuf_cache_theme_quark,
+                          GINT_TO_POINTER (1));
+    }
+}
+
+
+
+#ifdef ASYNC_ICON_LOADING
+static void
+xfce_panel_image_request_free (XfcePanelImageRequest *request)
+{
+  panel_return_if_fail (request->images == NULL);
+
+  g_object_unref (G_OBJECT (request->cancellable));
+  g_object_unref (G_OBJECT (request->icon_theme));
+  g_free (request->source);
+  g_free (request->key);
+  g_slice_free (XfcePanelImageRequest, request);
+}
+
+
+
+static void
+xfce_panel_image_request_finish (XfcePanelImageRequest *request,
+                                 GdkPixbuf             *pixbuf)
+{
+  GdkPixbuf      *scaled = NULL;
+  GSList         *li;
+  XfcePanelImage *image;
+
+  /* all images lost interest in the result */
+  if (g_cancellable_is_cancelled (request->cancellable))
+    {
+      if (pixbuf != NULL)
+        g_object_unref (G_OBJECT (pixbuf));
+      xfce_panel_image_request_free (request);
+      return;
+    }
+
+  /* a newer request for the same key might be pending */
+  if (g_hash_table_lookup (pixbuf_requests, request->key) == request)
+    g_hash_table_remove (pixbuf_requests, request->key);
+
+  /* loading failed, try the fallbacks of the synchronous loader */
+  if (G_UNLIKELY (pixbuf == NULL))
+    pixbuf = xfce_panel_pixbuf_from_source_at_size (request->source, request->icon_theme,
+                                                    request->dest_width * request->scale,
+                                                    request->dest_height * request->scale);
+
+  if (G_LIKELY (pixbuf != NULL))
+    {
+      scaled = xfce_panel_image_scale_to_device (pixbuf,
+                                                 request->dest_width,
+                                                 request->dest_height,
+                                                 request->scale);
+      g_object_unref (G_OBJECT (pixbuf));
+    }
+
+  /* icons loaded before a theme change are only shown until the
+   * images reload, they are not reused */
+  if (G_LIKELY (scaled != NULL)
+      && request->generation == pixbuf_cache_generation)
+    xfce_panel_image_cache_insert (request->key, scaled, request->icon_theme);
+
+  for (li = request->images; li != NULL; li = li->next)
+    {
+      image = XFCE_PANEL_IMAGE (li->data);
+      image->priv->request = NULL;
+
+      if (G_LIKELY (scaled != NULL))
+        {
+          xfce_panel_image_cache_free (image);
+          image->priv->cache = g_object_ref (G_OBJECT (scaled));
+          gtk_widget_queue_draw (GTK_WIDGET (image));
+        }
+    }
+
+  g_slist_free (request->images);
+  request->images = NULL;
+
+  if (scaled != NULL)
+    g_object_unref (G_OBJECT (scaled));
+
+  xfce_panel_image_request_free (request);
+}
+
+
+
+static void
+xfce_panel_image_request_icon_ready (GObject      *source_object,
+                                     GAsyncResult *result,
+                                     gpointer      user_data)
+{
+  GdkPixbuf *pixbuf;
+
+  pixbuf = gtk_icon_info_load_icon_finish (GTK_ICON_INFO (source_object), result, NULL);
+  xfce_panel_image_request_finish (user_data, pixbuf);
+}
+
+
+
+static void
+xfce_panel_image_request_file_thread (GTask        *task,
+                                      gpointer      source_object,
+                                      gpointer      task_data,
+                                      GCancellable *cancellable)
+{
+  XfcePanelImageRequest *request = task_data;
+  GdkPixbuf             *pixbuf;
+
+  /* only the source is used here, which is never modified */
+  pixbuf = gdk_pixbuf_new_from_file (request->source, NULL);
+  g_task_return_pointer (task, pixbuf, pixbuf != NULL ? g_object_unref : NULL);
+}
+
+
+
+static void
+xfce_panel_image_request_file_ready (GObject      *source_object,
+                                     GAsyncResult *result,
+                                     gpointer      user_data)
+{
+  GdkPixbuf *pixbuf;
+
+  pixbuf = g_task_propagate_pointer (G_TASK (result), NULL);
+  xfce_panel_image_request_finish (user_data, pixbuf);
+}
+
+
+
+static gboolean
+xfce_panel_image_request (XfcePanelImage *image,
+                          const gchar    *key,
+                          GtkIconTheme   *icon_theme,
+                          gint            dest_width,
+                          gint            dest_height,
+                          gint            scale)
+{
+  XfcePanelImagePrivate *priv = image->priv;
+  XfcePanelImageRequest *request;
+  GtkIconInfo           *info = NULL;
+  GTask                 *task;
+
+  panel_return_val_if_fail (priv->source != NULL, FALSE);
+  panel_return_val_if_fail (priv->request == NULL, FALSE);
+
+  if (G_UNLIKELY (pixbuf_requests == NULL))
+    pixbuf_requests = g_hash_table_new (g_str_hash, g_str_equal);
+
+  /* join a pending load of the same icon */
+  request = g_hash_table_lookup (pixbuf_requests, key);
+  if (request == NULL)
+    {
+      if (!g_path_is_absolute (priv->source))
+        {
+          /* names not in the theme are handled by the fallbacks
+           * of the synchronous loader */
+          info = gtk_icon_theme_lookup_icon_for_scale (icon_theme, priv->source,
+                                                       MIN (dest_width, dest_height),
+                                                       scale, 0);
+          if (info == NULL)
+            return FALSE;
+        }
+
+      request = g_slice_new0 (XfcePanelImageRequest);
+      request->key = g_strdup (key);
+      request->source = g_strdup (priv->source);
+      request->icon_theme = g_object_ref (G_OBJECT (icon_theme));
+      request->dest_width = dest_width;
+      request->dest_height = dest_height;
+      request->scale = scale;
+      request->generation = pixbuf_cache_generation;
+      request->cancellable = g_cancellable_new ();
+      g_hash_table_insert (pixbuf_requests, request->key, request);
+
+      /* flush pending loads when the theme changes */
+      xfce_panel_image_cache_watch_theme (icon_theme);
+
+      if (info != NULL)
+        {
+          gtk_icon_info_load_icon_async (info, request->cancellable,
+                                         xfce_panel_image_request_icon_ready,
+                                         request);
+          g_object_unref (G_OBJECT (info));
+        }
+      else
+        {
+          task = g_task_new (NULL, request->cancellable,
+                             xfce_panel_image_request_file_ready, request);
+          g_task_set_task_data (task, request, NULL);
+          g_task_run_in_thread (task, xfce_panel_image_request_file_thread);
+          g_object_unref (G_OBJECT (task));
+        }
+    }
+
+  request->images = g_slist_prepend (request->images, image);
+  priv->request = request;
+
+  return TRUE;
+}
+
+
+
+static void
+xfce_panel_image_request_detach (XfcePanelImage *image)
+{
+  XfcePanelImageRequest *request = image->priv->request;
+
+  if (request == NULL)
+    return;
+
+  image->priv->request = NULL;
+  request->images = g_slist_remove (request->images, image);
+
+  if (request->images == NULL)
+    {
+      /* nobody is waiting for this icon anymore, the request is
+       * released when the async operation returns */
+      if (g_hash_table_lookup (pixbuf_requests, request->key) == request)
+        g_hash_table_remove (pixbuf_requests, request->key);
+      g_cancellable_cancel (request->cancellable);
+    }
+}
+#endif
+
+
+
 /**
  * xfce_panel_image_new:
  *
@@ -959,6 +1523,10 @@ xfce_panel_image_clear (XfcePanelImage *image)
   if (priv->idle_load_id != 0)
     g_source_remove (priv->idle_load_id);
 
+#ifdef ASYNC_ICON_LOADING
+  xfce_panel_image_request_detach (image);
+#endif
+
   if (priv->source != NULL)
     {
      g_free (priv->source);
@@ -966,7 +1534,7 @@ xfce_panel_image_clear (XfcePanelImage *image)
     }
 
   xfce_panel_image_unref_null (priv->pixbuf);
-  xfce_panel_image_unref_null (priv->cache);
+  xfce_panel_image_cache_free (image);
 
   /* reset values */
   priv->width = -1;
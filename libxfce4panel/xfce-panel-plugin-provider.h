@@ -117,7 +117,8 @@ typedef enum /*< skip >*/
   PROVIDER_PROP_TYPE_ACTION_BACKGROUND_UNSET, /* none */
   PROVIDER_PROP_TYPE_ACTION_SHOW_CONFIGURE,   /* none */
   PROVIDER_PROP_TYPE_ACTION_SHOW_ABOUT,       /* none */
-  PROVIDER_PROP_TYPE_ACTION_ASK_REMOVE        /* none */
+  PROVIDER_PROP_TYPE_ACTION_ASK_REMOVE,       /* none */
+  PROVIDER_PROP_TYPE_SET_BACKGROUND_CACHE     /* string, wrapper only */
 }
 XfcePanelPluginProviderPropType;
 
@@ -60,6 +60,10 @@
 
 static void      panel_application_finalize           (GObject                *object);
 static gboolean  panel_application_autosave_timer     (gpointer                user_data);
+static gboolean  panel_application_get_property       (PanelApplication       *application,
+                                                       const gchar            *property,
+                                                       GType                   type,
+                                                       GValue                 *value);
 static void      panel_application_plugin_move        (GtkWidget              *item,
                                                        PanelApplication       *application);
 static gboolean  panel_application_plugin_insert      (PanelApplication       *application,
@@ -195,7 +199,8 @@ static void
 panel_application_init (PanelApplication *application)
 {
   GError *error = NULL;
-  gint    configver;
+  gint    configver = -1;
+  GValue  val = { 0, };
 
   application->windows = NULL;
   application->dialogs = NULL;
@@ -206,8 +211,17 @@ panel_application_init (PanelApplication *application)
   /* get the xfconf channel (singleton) */
   application->xfconf = panel_properties_get_channel (G_OBJECT (application));
 
+  /* load the entire channel in one call, the panels and plugins
+   * read their startup configuration from this snapshot */
+  panel_properties_snapshot_load (application->xfconf);
+
   /* check if we need to migrate configuration */
-  configver = xfconf_channel_get_int (application->xfconf, "/configver", -1);
+  if (panel_application_get_property (application, "/configver", G_TYPE_INT, &val))
+    {
+      configver = g_value_get_int (&val);
+      g_value_unset (&val);
+    }
+
   if (G_UNLIKELY (configver < XFCE4_PANEL_CONFIG_VERSION))
     {
       if (!g_spawn_command_line_sync (MIGRATE_BIN, NULL, NULL, NULL, &error))
@@ -215,11 +229,19 @@ panel_application_init (PanelApplication *application)
           xfce_dialog_show_error (NULL, error, _("Failed to launch the migration application"));
           g_error_free (error);
         }
+
+      /* the migration changed the channel behind our back */
+      panel_properties_snapshot_free ();
+      panel_properties_snapshot_load (application->xfconf);
     }
 
   /* check if we need to force all plugins to run external */
-  if (xfconf_channel_get_bool (application->xfconf, "/force-all-external", FALSE))
-    panel_module_factory_force_all_external ();
+  if (panel_application_get_property (application, "/force-all-external", G_TYPE_BOOLEAN, &val))
+    {
+      if (g_value_get_boolean (&val))
+        panel_module_factory_force_all_external ();
+      g_value_unset (&val);
+    }
 
   /* get a factory reference so it never unloads */
   application->factory = panel_module_factory_get ();
@@ -279,6 +301,43 @@ panel_application_autosave_timer (gpointer user_data)
 
 
 
+static gboolean
+panel_application_get_property (PanelApplication *application,
+                                const gchar      *property,
+                                GType             type,
+                                GValue           *value)
+{
+  GValue stored = { 0, };
+
+  panel_return_val_if_fail (PANEL_IS_APPLICATION (application), FALSE);
+  panel_return_val_if_fail (XFCONF_IS_CHANNEL (application->xfconf), FALSE);
+
+  /* read from the startup snapshot, if still loaded */
+  if (!panel_properties_snapshot_get (application->xfconf, property, &stored))
+    return FALSE;
+
+  if (G_VALUE_HOLDS (&stored, type))
+    {
+      /* hand over the value */
+      *value = stored;
+      return TRUE;
+    }
+
+  g_value_init (value, type);
+  if (!g_value_transform (&stored, value))
+    {
+      g_value_unset (value);
+      g_value_unset (&stored);
+      return FALSE;
+    }
+
+  g_value_unset (&stored);
+
+  return TRUE;
+}
+
+
+
 static void
 panel_application_xfconf_window_bindings (PanelApplication *application,
                                           PanelWindow      *window,
@@ -345,13 +404,18 @@ panel_application_load_real (PanelApplication *application)
   GPtrArray    *panels;
   gint          panel_id;
   gboolean      save_changed_ids = FALSE;
+  GValue        ids = { 0, };
+  GValue        prop = { 0, };
 
   panel_return_if_fail (PANEL_IS_APPLICATION (application));
   panel_return_if_fail (XFCONF_IS_CHANNEL (application->xfconf));
 
+  /* reload the snapshot if loading was delayed */
+  panel_properties_snapshot_load (application->xfconf);
+
   display = gdk_display_get_default ();
 
-  if (xfconf_channel_get_property (application->xfconf, "/panels", &val)
+  if (panel_properties_snapshot_get (application->xfconf, "/panels", &val)
       && (G_VALUE_HOLDS_UINT (&val)
           || G_VALUE_HOLDS (&val, PANEL_PROPERTIES_TYPE_VALUE_ARRAY)))
     {
@@ -387,7 +451,13 @@ panel_application_load_real (PanelApplication *application)
 
           /* start the panel directly on the correct screen */
           g_snprintf (buf, sizeof (buf), "/panels/panel-%d/output-name", panel_id);
-          output_name = xfconf_channel_get_string (application->xfconf, buf, NULL);
+          output_name = NULL;
+          if (panel_application_get_property (application, buf, G_TYPE_STRING, &prop))
+            {
+              output_name = g_value_dup_string (&prop);
+              g_value_unset (&prop);
+            }
+
           if (output_name != NULL
               && strncmp (output_name, "screen-", 7) == 0
               && sscanf (output_name, "screen-%d", &screen_num) == 1)
@@ -402,9 +472,15 @@ panel_application_load_real (PanelApplication *application)
 
           /* walk all the plugins on the panel */
           g_snprintf (buf, sizeof (buf), "/panels/panel-%d/plugin-ids", panel_id);
-          array = xfconf_channel_get_arrayv (application->xfconf, buf);
-          if (array == NULL)
+          if (!panel_application_get_property (application, buf,
+                                               PANEL_PROPERTIES_TYPE_VALUE_ARRAY, &ids))
             continue;
+          array = g_value_get_boxed (&ids);
+          if (array == NULL)
+            {
+              g_value_unset (&ids);
+              continue;
+            }
 
           for (j = 0; j < array->len; j++)
             {
@@ -415,7 +491,12 @@ panel_application_load_real (PanelApplication *application)
 
               /* get the plugin name */
               g_snprintf (buf, sizeof (buf), "/plugins/plugin-%d", unique_id);
-              name = xfconf_channel_get_string (application->xfconf, buf, NULL);
+              name = NULL;
+              if (panel_application_get_property (application, buf, G_TYPE_STRING, &prop))
+                {
+                  name = g_value_dup_string (&prop);
+                  g_value_unset (&prop);
+                }
 
               /* append the plugin to the panel */
               if (unique_id < 1 || name == NULL
@@ -438,7 +519,7 @@ panel_application_load_real (PanelApplication *application)
               g_free (name);
             }
 
-          xfconf_array_free (array);
+          g_value_unset (&ids);
         }
 
       /* free xfconf array or uint */
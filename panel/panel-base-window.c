@@ -40,6 +40,8 @@
 #define PANEL_BASE_CSS        ".xfce4-panel.background { border-style: solid; }"\
                               ".xfce4-panel.background button { background: transparent; padding: 0; }"\
                               ".xfce4-panel.background.marching-ants { border: 1px dashed #ff0000; }"
+#define OPACITY_DURATION      (200)
+#define N_BG_STYLES           (PANEL_BG_STYLE_IMAGE + 1)
 
 
 
@@ -63,17 +65,16 @@ static gboolean panel_base_window_active_timeout              (gpointer
 static void     panel_base_window_active_timeout_destroyed    (gpointer              user_data);
 static void     panel_base_window_set_background_color_css    (PanelBaseWindow      *window);
 static void     panel_base_window_set_background_image_css    (PanelBaseWindow      *window);
+static GtkCssProvider *panel_base_window_image_provider       (const gchar          *css_string);
 static void     panel_base_window_set_background_css          (PanelBaseWindow      *window,
+                                                               PanelBgStyle          style,
                                                                gchar                *css_string);
+static void     panel_base_window_opacity_fade                (PanelBaseWindow      *window,
+                                                               gdouble               opacity);
+static void     panel_base_window_opacity_set                 (PanelBaseWindow      *window,
+                                                               gdouble               opacity);
 static void     panel_base_window_set_plugin_data             (PanelBaseWindow      *window,
                                                                GtkCallback           func);
-static void     panel_base_window_set_plugin_opacity          (GtkWidget            *widget,
-                                                               gpointer              user_data,
-                                                               gdouble               opacity);
-static void     panel_base_window_set_plugin_enter_opacity    (GtkWidget            *widget,
-                                                               gpointer              user_data);
-static void     panel_base_window_set_plugin_leave_opacity    (GtkWidget            *widget,
-                                                               gpointer              user_data);
 static void     panel_base_window_set_plugin_background_color (GtkWidget            *widget,
                                                                gpointer              user_data);
 static void     panel_base_window_set_plugin_background_image (GtkWidget            *widget,
@@ -98,11 +99,20 @@ struct _PanelBaseWindowPrivate
 {
   PanelBorders     borders;
 
-  /* background css style provider */
-  GtkCssProvider  *css_provider;
+  /* background css style provider for each background style, the
+   * css it was loaded with and the style of the attached provider */
+  GtkCssProvider  *css_providers[N_BG_STYLES];
+  gchar           *css_strings[N_BG_STYLES];
+  gint             css_active;
 
   /* active window timeout id */
   guint            active_timeout_id;
+
+  /* opacity transition between the enter and leave opacity */
+  guint            opacity_tick_id;
+  gint64           opacity_start;
+  gdouble          opacity_from;
+  gdouble          opacity_to;
 };
 
 
@@ -111,6 +121,11 @@ G_DEFINE_TYPE (PanelBaseWindow, panel_base_window, GTK_TYPE_WINDOW)
 
 
 
+/* shared background image css providers, indexed by their css */
+static GHashTable *image_providers = NULL;
+
+
+
 static void
 panel_base_window_class_init (PanelBaseWindowClass *klass)
 {
@@ -197,6 +212,7 @@ static void
 panel_base_window_init (PanelBaseWindow *window)
 {
   GtkStyleContext *context;
+  guint            i;
 
   window->priv = G_TYPE_INSTANCE_GET_PRIVATE (window, PANEL_TYPE_BASE_WINDOW, PanelBaseWindowPrivate);
 
@@ -207,9 +223,18 @@ panel_base_window_init (PanelBaseWindow *window)
   window->enter_opacity = 1.00;
   window->leave_opacity = 1.00;
 
-  window->priv->css_provider = gtk_css_provider_new ();
+  for (i = 0; i < N_BG_STYLES; i++)
+    {
+      window->priv->css_providers[i] = gtk_css_provider_new ();
+      window->priv->css_strings[i] = NULL;
+    }
+  window->priv->css_active = -1;
   window->priv->borders = PANEL_BORDER_NONE;
   window->priv->active_timeout_id = 0;
+  window->priv->opacity_tick_id = 0;
+  window->priv->opacity_start = 0;
+  window->priv->opacity_from = 1.00;
+  window->priv->opacity_to = 1.00;
 
   /* some wm require stick to show the window on all workspaces, on xfwm4
    * the type-hint already takes care of that */
@@ -310,11 +335,7 @@ panel_base_window_set_property (GObject      *object,
       /* set the new leave opacity */
       window->leave_opacity = g_value_get_uint (value) / 100.00;
       if (window->is_composited)
-        {
-          gtk_widget_set_opacity (GTK_WIDGET (object), window->leave_opacity);
-          panel_base_window_set_plugin_data (window,
-                                             panel_base_window_set_plugin_leave_opacity);
-        }
+        panel_base_window_opacity_set (window, window->leave_opacity);
       break;
 
     case PROP_BACKGROUND_STYLE:
@@ -416,6 +437,7 @@ static void
 panel_base_window_finalize (GObject *object)
 {
   PanelBaseWindow *window = PANEL_BASE_WINDOW (object);
+  guint            i;
 
   /* stop running marching ants timeout */
   if (window->priv->active_timeout_id != 0)
@@ -425,7 +447,11 @@ panel_base_window_finalize (GObject *object)
   g_free (window->background_image);
   if (window->background_rgba != NULL)
     gdk_rgba_free (window->background_rgba);
-  g_object_unref (window->priv->css_provider);
+  for (i = 0; i < N_BG_STYLES; i++)
+    {
+      g_object_unref (window->priv->css_providers[i]);
+      g_free (window->priv->css_strings[i]);
+    }
 
   (*G_OBJECT_CLASS (panel_base_window_parent_class)->finalize) (object);
 }
@@ -469,11 +495,7 @@ panel_base_window_enter_notify_event (GtkWidget        *widget,
   if (event->detail != GDK_NOTIFY_INFERIOR
       && PANEL_BASE_WINDOW (widget)->is_composited
       && window->leave_opacity != window->enter_opacity)
-    {
-      gtk_widget_set_opacity (GTK_WIDGET (widget), window->enter_opacity);
-      panel_base_window_set_plugin_data (window,
-                                         panel_base_window_set_plugin_enter_opacity);
-    }
+    panel_base_window_opacity_fade (window, window->enter_opacity);
 
   return FALSE;
 }
@@ -491,11 +513,7 @@ panel_base_window_leave_notify_event (GtkWidget        *widget,
   if (event->detail != GDK_NOTIFY_INFERIOR
       && PANEL_BASE_WINDOW (widget)->is_composited
       && window->leave_opacity != window->enter_opacity)
-    {
-      gtk_widget_set_opacity (GTK_WIDGET (widget), window->leave_opacity);
-      panel_base_window_set_plugin_data (window,
-                                         panel_base_window_set_plugin_leave_opacity);
-    }
+    panel_base_window_opacity_fade (window, window->leave_opacity);
 
   return FALSE;
 }
@@ -516,12 +534,7 @@ panel_base_window_composited_changed (GtkWidget *widget)
     return;
 
   if (window->is_composited)
-    {
-      gtk_widget_set_opacity (GTK_WIDGET (widget), window->leave_opacity);
-      panel_base_window_set_plugin_data (window,
-                                         panel_base_window_set_plugin_leave_opacity);
-
-    }
+    panel_base_window_opacity_set (window, window->leave_opacity);
 
   panel_debug (PANEL_DEBUG_BASE_WINDOW,
                "%p: compositing=%s", window,
@@ -545,6 +558,86 @@ panel_base_window_composited_changed (GtkWidget *widget)
 
 
 
+static gboolean
+panel_base_window_opacity_tick (GtkWidget     *widget,
+                                GdkFrameClock *frame_clock,
+                                gpointer       user_data)
+{
+  PanelBaseWindowPrivate *priv = PANEL_BASE_WINDOW (widget)->priv;
+  gdouble                 t;
+
+  /* the last frame time can be old when the clock was idle, so the
+   * transition starts with the first frame */
+  if (priv->opacity_start == 0)
+    priv->opacity_start = gdk_frame_clock_get_frame_time (frame_clock);
+
+  t = (gdouble) (gdk_frame_clock_get_frame_time (frame_clock) - priv->opacity_start)
+      / (OPACITY_DURATION * 1000);
+  t = CLAMP (t, 0.0, 1.0);
+
+  gtk_widget_set_opacity (widget, priv->opacity_from
+                                  + (priv->opacity_to - priv->opacity_from) * t);
+
+  if (t < 1.0)
+    return G_SOURCE_CONTINUE;
+
+  priv->opacity_tick_id = 0;
+
+  return G_SOURCE_REMOVE;
+}
+
+
+
+static void
+panel_base_window_opacity_fade (PanelBaseWindow *window,
+                                gdouble          opacity)
+{
+  PanelBaseWindowPrivate *priv = window->priv;
+
+  /* without compositor the opacity has no effect */
+  if (!window->is_composited)
+    return;
+
+  if (!gtk_widget_get_mapped (GTK_WIDGET (window)))
+    {
+      panel_base_window_opacity_set (window, opacity);
+      return;
+    }
+
+  /* only the toplevel opacity is animated, the compositor applies it
+   * to the embedded external plugins too */
+  priv->opacity_from = gtk_widget_get_opacity (GTK_WIDGET (window));
+  priv->opacity_to = opacity;
+  priv->opacity_start = 0;
+
+  if (priv->opacity_tick_id == 0)
+    priv->opacity_tick_id =
+      gtk_widget_add_tick_callback (GTK_WIDGET (window),
+                                    panel_base_window_opacity_tick,
+                                    NULL, NULL);
+}
+
+
+
+static void
+panel_base_window_opacity_set (PanelBaseWindow *window,
+                               gdouble          opacity)
+{
+  PanelBaseWindowPrivate *priv = window->priv;
+
+  /* stop a running transition */
+  if (priv->opacity_tick_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (window), priv->opacity_tick_id);
+      priv->opacity_tick_id = 0;
+    }
+
+  if (gtk_widget_get_opacity (GTK_WIDGET (window)) != opacity)
+    gtk_widget_set_opacity (GTK_WIDGET (window), opacity);
+}
+
+
+
 static gboolean
 panel_base_window_active_timeout (gpointer user_data)
 {
@@ -583,11 +676,13 @@ panel_base_window_active_timeout_destroyed (gpointer user_data)
 static void
 panel_base_window_set_background_color_css (PanelBaseWindow *window) {
   gchar                  *css_string;
+  gchar                  *color_text;
   panel_return_if_fail (window->background_rgba != NULL);
+  color_text = gdk_rgba_to_string (window->background_rgba);
   css_string = g_strdup_printf (".xfce4-panel.background { background-color: %s; border-color: transparent; } %s",
-                                gdk_rgba_to_string (window->background_rgba),
-                                PANEL_BASE_CSS);
-  panel_base_window_set_background_css (window, css_string);
+                                color_text, PANEL_BASE_CSS);
+  g_free (color_text);
+  panel_base_window_set_background_css (window, PANEL_BG_STYLE_COLOR, css_string);
 }
 
 
@@ -598,23 +693,101 @@ panel_base_window_set_background_image_css (PanelBaseWindow *window) {
   panel_return_if_fail (window->background_image != NULL);
   css_string = g_strdup_printf (".xfce4-panel.background { background-image: url('%s'); border-color: transparent; } %s",
                                 window->background_image, PANEL_BASE_CSS);
-  panel_base_window_set_background_css (window, css_string);
+  panel_base_window_set_background_css (window, PANEL_BG_STYLE_IMAGE, css_string);
 }
 
 
 
 static void
-panel_base_window_set_background_css (PanelBaseWindow *window, gchar *css_string) {
+panel_base_window_image_provider_weak_notify (gpointer  data,
+                                              GObject  *where_the_object_was)
+{
+  g_hash_table_remove (image_providers, data);
+}
+
+
+
+static GtkCssProvider *
+panel_base_window_image_provider (const gchar *css_string)
+{
+  GtkCssProvider *provider;
+  gchar          *key;
+
+  if (G_UNLIKELY (image_providers == NULL))
+    image_providers = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  /* all panels with the same background image share the provider, so
+   * gtk loads and decodes the image only once */
+  provider = g_hash_table_lookup (image_providers, css_string);
+  if (provider != NULL)
+    return g_object_ref (G_OBJECT (provider));
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider, css_string, -1, NULL);
+
+  key = g_strdup (css_string);
+  g_hash_table_insert (image_providers, key, provider);
+  g_object_weak_ref (G_OBJECT (provider),
+                     panel_base_window_image_provider_weak_notify, key);
+
+  return provider;
+}
+
+
+
+static void
+panel_base_window_set_background_css (PanelBaseWindow *window,
+                                      PanelBgStyle     style,
+                                      gchar           *css_string) {
+  PanelBaseWindowPrivate *priv = window->priv;
   GtkStyleContext        *context;
 
-  context = gtk_widget_get_style_context (GTK_WIDGET (window));
-  /* Reset the css style provider */
-  gtk_style_context_remove_provider (context, GTK_STYLE_PROVIDER (window->priv->css_provider));
-  gtk_css_provider_load_from_data (window->priv->css_provider, css_string, -1, NULL);
-  gtk_style_context_add_provider (context,
-                                  GTK_STYLE_PROVIDER (window->priv->css_provider),
-                                  GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
-  g_free (css_string);
+  panel_return_if_fail (style < N_BG_STYLES);
+
+  /* only parse the css again if it changed for this background style, a
+   * loaded provider that is already attached invalidates the style itself */
+  if (g_strcmp0 (priv->css_strings[style], css_string) != 0)
+    {
+      if (style == PANEL_BG_STYLE_IMAGE)
+        {
+          /* detach the old provider, it is replaced by another object */
+          if (priv->css_active == (gint) style)
+            {
+              context = gtk_widget_get_style_context (GTK_WIDGET (window));
+              gtk_style_context_remove_provider (context,
+                  GTK_STYLE_PROVIDER (priv->css_providers[style]));
+              priv->css_active = -1;
+            }
+
+          g_object_unref (priv->css_providers[style]);
+          priv->css_providers[style] = panel_base_window_image_provider (css_string);
+        }
+      else
+        {
+          gtk_css_provider_load_from_data (priv->css_providers[style], css_string, -1, NULL);
+        }
+
+      g_free (priv->css_strings[style]);
+      priv->css_strings[style] = css_string;
+    }
+  else
+    {
+      g_free (css_string);
+    }
+
+  /* switch providers when the background style changed, otherwise the
+   * style of the panel and the plugins is left untouched */
+  if (priv->css_active != (gint) style)
+    {
+      context = gtk_widget_get_style_context (GTK_WIDGET (window));
+      if (priv->css_active != -1)
+        gtk_style_context_remove_provider (context,
+            GTK_STYLE_PROVIDER (priv->css_providers[priv->css_active]));
+      gtk_style_context_add_provider (context,
+                                      GTK_STYLE_PROVIDER (priv->css_providers[style]),
+                                      GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+      priv->css_active = style;
+    }
 }
 
 
@@ -629,8 +802,16 @@ panel_base_window_reset_background_css (PanelBaseWindow *window) {
   gchar                   *color_text;
 
   context = gtk_widget_get_style_context (GTK_WIDGET (window));
-  gtk_style_context_remove_provider (context,
-                                     GTK_STYLE_PROVIDER (window->priv->css_provider));
+
+  /* the background color of the theme is needed, so detach a provider
+   * of another background style that overrides it */
+  if (priv->css_active != -1 && priv->css_active != PANEL_BG_STYLE_NONE)
+    {
+      gtk_style_context_remove_provider (context,
+          GTK_STYLE_PROVIDER (priv->css_providers[priv->css_active]));
+      priv->css_active = -1;
+    }
+
   /* Get the background color of the panel to draw the border */
   gtk_style_context_get (context, GTK_STATE_FLAG_NORMAL,
                          GTK_STYLE_PROPERTY_BACKGROUND_COLOR,
@@ -648,15 +829,11 @@ panel_base_window_reset_background_css (PanelBaseWindow *window) {
     color_text = gdk_rgba_to_string (background_rgba);
     base_css = g_strdup_printf ("%s .xfce4-panel.background { border-%s: 1px solid shade(%s, 0.7); }",
                                 PANEL_BASE_CSS, border_side, color_text);
-    gtk_css_provider_load_from_data (window->priv->css_provider, base_css, -1, NULL);
-    g_free(base_css);
     g_free(color_text);
   }
   else
-    gtk_css_provider_load_from_data (window->priv->css_provider, PANEL_BASE_CSS, -1, NULL);
-  gtk_style_context_add_provider (context,
-                                  GTK_STYLE_PROVIDER (window->priv->css_provider),
-                                  GTK_STYLE_PROVIDER_PRIORITY_APPLICATION);
+    base_css = g_strdup (PANEL_BASE_CSS);
+  panel_base_window_set_background_css (window, PANEL_BG_STYLE_NONE, base_css);
   gdk_rgba_free (background_rgba);
 }
 
@@ -675,42 +852,6 @@ panel_base_window_set_plugin_data (PanelBaseWindow *window,
 
 
 
-static void
-panel_base_window_set_plugin_enter_opacity (GtkWidget *widget,
-                                            gpointer   user_data)
-{
-  PanelBaseWindow *window = PANEL_BASE_WINDOW (user_data);
-
-  panel_base_window_set_plugin_opacity (widget, user_data, window->enter_opacity);
-}
-
-
-
-static void
-panel_base_window_set_plugin_leave_opacity (GtkWidget *widget,
-                                            gpointer   user_data)
-{
-  PanelBaseWindow *window = PANEL_BASE_WINDOW (user_data);
-
-  panel_base_window_set_plugin_opacity (widget, user_data, window->leave_opacity);
-}
-
-
-
-static void
-panel_base_window_set_plugin_opacity (GtkWidget *widget,
-                                      gpointer   user_data,
-                                      gdouble    opacity)
-{
-  panel_return_if_fail (XFCE_IS_PANEL_PLUGIN_PROVIDER (widget));
-  panel_return_if_fail (PANEL_IS_BASE_WINDOW (user_data));
-
-  if (PANEL_IS_PLUGIN_EXTERNAL (widget))
-    panel_plugin_external_set_opacity (PANEL_PLUGIN_EXTERNAL (widget), opacity);
-}
-
-
-
 static void
 panel_base_window_set_plugin_background_color (GtkWidget *widget,
                                                gpointer   user_data)
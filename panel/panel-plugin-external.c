@@ -29,7 +29,17 @@
 #ifdef HAVE_SYS_WAIT_H
 #include <sys/wait.h>
 #endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_ERRNO_H
+#include <errno.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
+#include <glib/gstdio.h>
 #include <gdk/gdk.h>
 #include <gdk/gdkx.h>
 #include <libxfce4util/libxfce4util.h>
@@ -47,6 +57,7 @@
 #include <panel/panel-module.h>
 #include <panel/panel-plugin-external.h>
 #include <panel/panel-plugin-external-46.h>
+#include <panel/panel-plugin-external-wrapper.h>
 #include <panel/panel-window.h>
 #include <panel/panel-dialogs.h>
 
@@ -104,9 +115,12 @@ static void         panel_plugin_external_set_locked              (XfcePanelPlug
                                                                    gboolean                          locked);
 static void         panel_plugin_external_ask_remove              (XfcePanelPluginProvider          *provider);
 static void         panel_plugin_external_set_sensitive           (PanelPluginExternal              *external);
+static void         panel_plugin_external_background_release     (PanelPluginExternal              *external);
 
 
 
+typedef struct _PanelPluginExternalBackground PanelPluginExternalBackground;
+
 struct _PanelPluginExternalPrivate
 {
   /* startup arguments */
@@ -126,6 +140,23 @@ struct _PanelPluginExternalPrivate
 
   /* delayed spawning */
   guint       spawn_timeout_id;
+
+  /* decoded background image shared with the wrapper */
+  PanelPluginExternalBackground *background;
+};
+
+struct _PanelPluginExternalBackground
+{
+  gchar  *key;
+  gchar  *image;
+  gchar  *filename;
+  guint   ref_count;
+
+  /* externals waiting for the export to finish */
+  GSList *waiters;
+
+  guint   pending : 1;
+  guint   exported : 1;
 };
 
 enum
@@ -260,6 +291,8 @@ panel_plugin_external_finalize (GObject *object)
   if (external->priv->restart_timer != NULL)
     g_timer_destroy (external->priv->restart_timer);
 
+  panel_plugin_external_background_release (external);
+
   g_object_unref (G_OBJECT (external->module));
 
   (*G_OBJECT_CLASS (panel_plugin_external_parent_class)->finalize) (object);
@@ -1115,26 +1148,6 @@ panel_plugin_external_restart (PanelPluginExternal *external)
 
 
 
-void
-panel_plugin_external_set_opacity (PanelPluginExternal *external,
-                                   gdouble              opacity)
-{
-  GValue value = { 0, };
-
-  panel_return_if_fail (PANEL_IS_PLUGIN_EXTERNAL (external));
-
-  g_value_init (&value, G_TYPE_DOUBLE);
-  g_value_set_double (&value, opacity);
-
-  panel_plugin_external_queue_add (external,
-                                   PROVIDER_PROP_TYPE_SET_OPACITY,
-                                   &value);
-
-  g_value_unset (&value);
-}
-
-
-
 void
 panel_plugin_external_set_background_color (PanelPluginExternal *external,
                                             const GdkRGBA       *color)
@@ -1143,6 +1156,8 @@ panel_plugin_external_set_background_color (PanelPluginExternal *external,
 
   panel_return_if_fail (PANEL_IS_PLUGIN_EXTERNAL (external));
 
+  panel_plugin_external_background_release (external);
+
   if (G_LIKELY (color != NULL))
     {
       g_value_init (&value, G_TYPE_STRING);
@@ -1163,14 +1178,298 @@ panel_plugin_external_set_background_color (PanelPluginExternal *external,
 
 
 
+/* decoded background images shared with the wrappers, by image key */
+static GHashTable *background_exports = NULL;
+
+
+
+static void
+panel_plugin_external_background_free (gpointer data)
+{
+  PanelPluginExternalBackground *background = data;
+
+  panel_return_if_fail (background->waiters == NULL);
+
+  if (background->exported)
+    g_unlink (background->filename);
+
+  g_free (background->key);
+  g_free (background->image);
+  g_free (background->filename);
+  g_slice_free (PanelPluginExternalBackground, background);
+}
+
+
+
+static void
+panel_plugin_external_background_unref (PanelPluginExternalBackground *background)
+{
+  panel_return_if_fail (background->ref_count > 0);
+
+  if (--background->ref_count == 0)
+    g_hash_table_remove (background_exports, background->key);
+}
+
+
+
+static void
+panel_plugin_external_background_prune (void)
+{
+  GDir        *dir;
+  const gchar *name;
+  gchar       *endptr;
+  gint64       pid;
+  gchar       *filename;
+
+  /* remove the images left behind by panels that did not exit cleanly */
+  dir = g_dir_open (g_get_user_runtime_dir (), 0, NULL);
+  if (G_UNLIKELY (dir == NULL))
+    return;
+
+  while ((name = g_dir_read_name (dir)) != NULL)
+    {
+      if (!g_str_has_prefix (name, PANEL_BACKGROUND_CACHE_PREFIX))
+        continue;
+
+      pid = g_ascii_strtoll (name + strlen (PANEL_BACKGROUND_CACHE_PREFIX), &endptr, 10);
+      if (*endptr != '-'
+          || pid <= 0
+          || pid == getpid ()
+          || kill ((pid_t) pid, 0) == 0
+          || errno != ESRCH)
+        continue;
+
+      filename = g_build_filename (g_get_user_runtime_dir (), name, NULL);
+      g_unlink (filename);
+      g_free (filename);
+    }
+
+  g_dir_close (dir);
+}
+
+
+
+static void
+panel_plugin_external_background_thread (GTask        *task,
+                                         gpointer      source_object,
+                                         gpointer      task_data,
+                                         GCancellable *cancellable)
+{
+  PanelPluginExternalBackground *background = task_data;
+  static gsize                   pruned = 0;
+  GdkPixbuf                     *pixbuf;
+  cairo_surface_t               *surface;
+  cairo_t                       *cr;
+  guint32                        header[4];
+  gchar                         *contents;
+  gsize                          length;
+  gboolean                       succeed;
+  GError                        *error = NULL;
+
+  if (g_once_init_enter (&pruned))
+    {
+      panel_plugin_external_background_prune ();
+      g_once_init_leave (&pruned, 1);
+    }
+
+  /* let the plugins report the error */
+  pixbuf = gdk_pixbuf_new_from_file (background->image, NULL);
+  if (G_UNLIKELY (pixbuf == NULL))
+    {
+      g_task_return_boolean (task, FALSE);
+      return;
+    }
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+                                        gdk_pixbuf_get_width (pixbuf),
+                                        gdk_pixbuf_get_height (pixbuf));
+  cr = cairo_create (surface);
+  gdk_cairo_set_source_pixbuf (cr, pixbuf, 0, 0);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+  cairo_surface_flush (surface);
+  g_object_unref (G_OBJECT (pixbuf));
+
+  header[0] = PANEL_BACKGROUND_CACHE_MAGIC;
+  header[1] = cairo_image_surface_get_width (surface);
+  header[2] = cairo_image_surface_get_height (surface);
+  header[3] = cairo_image_surface_get_stride (surface);
+
+  length = PANEL_BACKGROUND_CACHE_HEADER + (gsize) header[2] * header[3];
+  contents = g_malloc (length);
+  memcpy (contents, header, PANEL_BACKGROUND_CACHE_HEADER);
+  memcpy (contents + PANEL_BACKGROUND_CACHE_HEADER,
+          cairo_image_surface_get_data (surface),
+          (gsize) header[2] * header[3]);
+  cairo_surface_destroy (surface);
+
+  succeed = g_file_set_contents (background->filename, contents, length, &error);
+  if (!succeed)
+    {
+      g_warning ("Failed to share the background image: %s", error->message);
+      g_error_free (error);
+    }
+
+  g_free (contents);
+
+  g_task_return_boolean (task, succeed);
+}
+
+
+
+static void
+panel_plugin_external_background_send (PanelPluginExternal           *external,
+                                       PanelPluginExternalBackground *background)
+{
+  GValue value = { 0, };
+
+  g_value_init (&value, G_TYPE_STRING);
+
+  /* the wrapper keeps decoding the image itself if the
+   * decoded image is missing or cannot be mapped */
+  g_value_set_string (&value, background->image);
+  panel_plugin_external_queue_add (external,
+                                   PROVIDER_PROP_TYPE_SET_BACKGROUND_IMAGE,
+                                   &value);
+
+  if (background->exported)
+    {
+      g_value_set_string (&value, background->filename);
+      panel_plugin_external_queue_add (external,
+                                       PROVIDER_PROP_TYPE_SET_BACKGROUND_CACHE,
+                                       &value);
+    }
+
+  g_value_unset (&value);
+}
+
+
+
+static void
+panel_plugin_external_background_exported (GObject      *source_object,
+                                           GAsyncResult *result,
+                                           gpointer      user_data)
+{
+  PanelPluginExternalBackground *background = user_data;
+  GSList                        *waiters, *li;
+
+  background->pending = FALSE;
+  background->exported = g_task_propagate_boolean (G_TASK (result), NULL);
+
+  waiters = background->waiters;
+  background->waiters = NULL;
+
+  for (li = waiters; li != NULL; li = li->next)
+    panel_plugin_external_background_send (li->data, background);
+
+  g_slist_free (waiters);
+
+  /* release the reference of the task */
+  panel_plugin_external_background_unref (background);
+}
+
+
+
+static PanelPluginExternalBackground *
+panel_plugin_external_background_get (const gchar *image)
+{
+  PanelPluginExternalBackground *background;
+  GStatBuf                       st;
+  gchar                         *key;
+  gchar                         *checksum;
+  GTask                         *task;
+
+  if (g_stat (image, &st) != 0)
+    return NULL;
+
+  key = g_strdup_printf ("%s:%" G_GINT64_FORMAT ":%" G_GINT64_FORMAT,
+                         image, (gint64) st.st_mtime, (gint64) st.st_size);
+
+  if (G_UNLIKELY (background_exports == NULL))
+    background_exports = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+                                                panel_plugin_external_background_free);
+
+  /* decode each image only once for all wrappers */
+  background = g_hash_table_lookup (background_exports, key);
+  if (background != NULL)
+    {
+      g_free (key);
+      background->ref_count++;
+      return background;
+    }
+
+  background = g_slice_new0 (PanelPluginExternalBackground);
+  background->key = key;
+  background->image = g_strdup (image);
+  background->pending = TRUE;
+
+  /* the pid makes it possible to remove the file after a crash */
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA1, key, -1);
+  background->filename = g_strdup_printf ("%s" G_DIR_SEPARATOR_S PANEL_BACKGROUND_CACHE_PREFIX "%d-%s",
+                                          g_get_user_runtime_dir (), (gint) getpid (), checksum);
+  g_free (checksum);
+
+  /* one reference for the caller and one for the task */
+  background->ref_count = 2;
+  g_hash_table_insert (background_exports, background->key, background);
+
+  /* decode and write the image without blocking the panel */
+  task = g_task_new (NULL, NULL, panel_plugin_external_background_exported, background);
+  g_task_set_task_data (task, background, NULL);
+  g_task_run_in_thread (task, panel_plugin_external_background_thread);
+  g_object_unref (G_OBJECT (task));
+
+  return background;
+}
+
+
+
+static void
+panel_plugin_external_background_release (PanelPluginExternal *external)
+{
+  PanelPluginExternalBackground *background = external->priv->background;
+
+  if (background == NULL)
+    return;
+
+  external->priv->background = NULL;
+
+  background->waiters = g_slist_remove (background->waiters, external);
+  panel_plugin_external_background_unref (background);
+}
+
+
+
 void
 panel_plugin_external_set_background_image (PanelPluginExternal *external,
                                             const gchar         *image)
 {
-  GValue value = { 0, };
+  GValue                         value = { 0, };
+  PanelPluginExternalBackground *background;
 
   panel_return_if_fail (PANEL_IS_PLUGIN_EXTERNAL (external));
 
+  panel_plugin_external_background_release (external);
+
+  if (image != NULL
+      && PANEL_IS_PLUGIN_EXTERNAL_WRAPPER (external))
+    {
+      /* the wrapper maps the image decoded once by the panel, the file
+       * lives in the runtime directory, which is normally a tmpfs */
+      background = panel_plugin_external_background_get (image);
+      if (background != NULL)
+        {
+          external->priv->background = background;
+
+          if (background->pending)
+            background->waiters = g_slist_prepend (background->waiters, external);
+          else
+            panel_plugin_external_background_send (external, background);
+
+          return;
+        }
+    }
+
   if (!external->priv->embedded
       && PANEL_IS_PLUGIN_EXTERNAL_46 (external))
     {
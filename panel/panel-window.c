@@ -63,6 +63,9 @@
 #define DEFAULT_POPUP_DELAY   (225)
 #define DEFAULT_POPDOWN_DELAY (350)
 #define DEFAULT_ATUOHIDE_SIZE (3)
+#define SLIDE_DURATION        (150)
+#define LAYOUT_SETTLE_DELAY   (250)
+#define LAYOUT_CACHE_SIZE     (16)
 #define HANDLE_SPACING        (4)
 #define HANDLE_DOTS           (2)
 #define HANDLE_PIXELS         (2)
@@ -74,6 +77,8 @@
 
 
 
+typedef struct _OverlapWindow OverlapWindow;
+typedef struct _LayoutCache   LayoutCache;
 typedef enum _StrutsEgde    StrutsEgde;
 typedef enum _AutohideBehavior AutohideBehavior;
 typedef enum _AutohideState AutohideState;
@@ -148,22 +153,22 @@ static SnapPosition panel_window_snap_position                        (PanelWind
 static void         panel_window_display_layout_debug                 (GtkWidget        *widget);
 static void         panel_window_screen_layout_changed                (GdkScreen        *screen,
                                                                        PanelWindow      *window);
-static void         panel_window_active_window_changed                (WnckScreen       *screen,
-                                                                       WnckWindow       *previous_window,
-                                                                       PanelWindow      *window);
-static void         panel_window_active_window_geometry_changed       (WnckWindow       *active_window,
-                                                                       PanelWindow      *window);
-static void         panel_window_active_window_state_changed          (WnckWindow       *active_window,
-                                                                       WnckWindowState   changed,
-                                                                       WnckWindowState   new,
+static void         panel_window_screen_geometry_changed              (GdkScreen        *screen,
                                                                        PanelWindow      *window);
+static guint        panel_window_screen_layout_hash                   (GdkScreen        *screen);
+static void         panel_window_layout_cache_free                    (gpointer          data);
+static gboolean     panel_window_overlap_tick                         (GtkWidget        *widget,
+                                                                       GdkFrameClock    *frame_clock,
+                                                                       gpointer          user_data);
+static void         panel_window_autohide_evaluate                    (PanelWindow      *window);
+static void         panel_window_autohide_slide_move                  (PanelWindow      *window);
+static void         panel_window_autohide_slide_stop                  (PanelWindow      *window);
 static void         panel_window_autohide_queue                       (PanelWindow      *window,
                                                                        AutohideState     new_state);
 static void         panel_window_set_autohide_behavior                (PanelWindow      *window,
                                                                        AutohideBehavior  behavior);
 static void         panel_window_update_autohide_window               (PanelWindow      *window,
-                                                                       WnckScreen       *screen,
-                                                                       WnckWindow       *active_window);
+                                                                       WnckScreen       *screen);
 static void         panel_window_menu_popup                           (PanelWindow      *window,
                                                                        guint32           event_time,
                                                                        gboolean          show_tic_tac_toe);
@@ -281,6 +286,33 @@ enum
   N_STRUTS
 };
 
+struct _LayoutCache
+{
+  /* randr configuration and panel settings the area was computed for */
+  guint         config;
+  gchar        *output_name;
+  guint         span_monitors : 1;
+  gint          base_x;
+  gint          base_y;
+  StrutsEgde    struts_edge_in;
+
+  /* computed working area and struts edge */
+  GdkRectangle  area;
+  StrutsEgde    struts_edge;
+};
+
+struct _OverlapWindow
+{
+  WnckWindow *wnck_window;
+
+  /* cached _NET_FRAME_EXTENTS decoration height, -1 if unknown,
+   * refreshed on property changes */
+  gint        frame_extents_height;
+
+  guint       overlaps : 1;
+  guint       queued : 1;
+};
+
 struct _PanelWindowClass
 {
   PanelBaseWindowClass __parent__;
@@ -301,6 +333,22 @@ struct _PanelWindow
   GdkScreen           *screen;
   GdkRectangle         area;
 
+  /* input of the last applied layout, used to skip window moves and
+   * resizes when a layout update did not change anything */
+  guint                layout_valid : 1;
+  StrutsEgde           layout_struts_edge;
+  SnapPosition         layout_snap_position;
+  XfcePanelPluginMode  layout_mode;
+  gint                 layout_base_x;
+  gint                 layout_base_y;
+
+  /* working areas computed per randr configuration hash, so returning
+   * to a known monitor setup does not walk all the monitors again, and
+   * the timeout to wait until the configuration settles */
+  guint                layout_config;
+  GHashTable          *layout_cache;
+  guint                layout_settle_id;
+
   /* struts information */
   StrutsEgde           struts_edge;
   gulong               struts[N_STRUTS];
@@ -321,7 +369,6 @@ struct _PanelWindow
 
   /* autohiding */
   WnckScreen          *wnck_screen;
-  WnckWindow          *wnck_active_window;
   GtkWidget           *autohide_window;
   AutohideBehavior     autohide_behavior;
   AutohideState        autohide_state;
@@ -330,6 +377,25 @@ struct _PanelWindow
   gint                 autohide_grab_block;
   gint                 autohide_size;
 
+  /* slide animation between the hidden and visible positions, the
+   * progress is 0.0 when the panel is fully visible */
+  guint                autohide_slide_id;
+  gint64               autohide_slide_start;
+  gdouble              autohide_slide_progress;
+  guint                autohide_slide_in : 1;
+
+  /* pending overlap evaluation, handled at most once per frame */
+  guint                autohide_evaluate_id;
+
+  /* windows on the wnck screen for intelligent autohiding, indexed
+   * by xid, with the changed windows queued for the next evaluation
+   * and the number of windows overlapping overlap_area */
+  GHashTable          *overlap_windows;
+  GQueue              *overlap_queue;
+  guint                overlap_count;
+  guint                overlap_rescan : 1;
+  GdkRectangle         overlap_area;
+
   /* popup/down delay from gtk style */
   gint                 popup_delay;
   gint                 popdown_delay;
@@ -358,6 +424,9 @@ static GdkAtom cardinal_atom = 0;
 static GdkAtom net_wm_strut_atom = 0;
 #endif
 static GdkAtom net_wm_strut_partial_atom = 0;
+#ifdef GDK_WINDOWING_X11
+static Atom    net_frame_extents_atom = None;
+#endif
 
 
 
@@ -512,8 +581,12 @@ panel_window_init (PanelWindow *window)
   window->id = -1;
   window->locked = TRUE;
   window->screen = NULL;
+  window->layout_valid = FALSE;
+  window->layout_config = 0;
+  window->layout_cache = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                                NULL, panel_window_layout_cache_free);
+  window->layout_settle_id = 0;
   window->wnck_screen = NULL;
-  window->wnck_active_window = NULL;
   window->struts_edge = STRUTS_EDGE_NONE;
   window->struts_disabled = FALSE;
   window->mode = XFCE_PANEL_PLUGIN_MODE_HORIZONTAL;
@@ -530,6 +603,15 @@ panel_window_init (PanelWindow *window)
   window->autohide_block = 0;
   window->autohide_grab_block = 0;
   window->autohide_size = DEFAULT_ATUOHIDE_SIZE;
+  window->autohide_slide_id = 0;
+  window->autohide_slide_start = 0;
+  window->autohide_slide_progress = 0.0;
+  window->autohide_slide_in = FALSE;
+  window->autohide_evaluate_id = 0;
+  window->overlap_windows = NULL;
+  window->overlap_queue = NULL;
+  window->overlap_count = 0;
+  window->overlap_rescan = FALSE;
   window->popup_delay = DEFAULT_POPUP_DELAY;
   window->popdown_delay = DEFAULT_POPDOWN_DELAY;
   window->base_x = -1;
@@ -784,13 +866,19 @@ panel_window_finalize (GObject *object)
 {
   PanelWindow *window = PANEL_WINDOW (object);
 
-  /* disconnect from active screen and window */
-  panel_window_update_autohide_window (window, NULL, NULL);
+  /* stop tracking the windows on the screen */
+  panel_window_update_autohide_window (window, NULL);
 
   /* stop running autohide timeout */
   if (G_UNLIKELY (window->autohide_timeout_id != 0))
     g_source_remove (window->autohide_timeout_id);
 
+  /* stop waiting for the screen layout to settle */
+  if (G_UNLIKELY (window->layout_settle_id != 0))
+    g_source_remove (window->layout_settle_id);
+
+  g_hash_table_destroy (window->layout_cache);
+
   /* destroy the autohide window */
   if (window->autohide_window != NULL)
     gtk_widget_destroy (window->autohide_window);
@@ -919,9 +1007,9 @@ panel_window_leave_notify_event (GtkWidget        *widget,
   if (event->detail != GDK_NOTIFY_INFERIOR
       && window->autohide_state != AUTOHIDE_DISABLED
       && window->autohide_state != AUTOHIDE_BLOCKED) {
-    /* simulate a geometry change to check for overlapping windows with intelligent hiding */
+    /* check for overlapping windows with intelligent hiding */
     if (window->autohide_behavior == AUTOHIDE_BEHAVIOR_INTELLIGENTLY)
-      panel_window_active_window_geometry_changed (window->wnck_active_window, window);
+      panel_window_autohide_evaluate (window);
     /* otherwise just hide the panel */
     else
       panel_window_autohide_queue (window, AUTOHIDE_POPDOWN);
@@ -1362,6 +1450,9 @@ panel_window_size_allocate (GtkWidget     *widget,
           break;
         }
 
+      /* a resize during the slide out ends the animation */
+      panel_window_autohide_slide_stop (window);
+
       /* position the autohide window */
       panel_window_size_allocate_set_xy (window, w, h, &x, &y);
       panel_base_window_move_resize (PANEL_BASE_WINDOW (window->autohide_window),
@@ -1384,7 +1475,10 @@ panel_window_size_allocate (GtkWidget     *widget,
                                        -9999, -9999, -1, -1);
     }
 
-  gtk_window_move (GTK_WINDOW (window), window->alloc.x, window->alloc.y);
+  if (G_UNLIKELY (window->autohide_slide_id != 0))
+    panel_window_autohide_slide_move (window);
+  else
+    gtk_window_move (GTK_WINDOW (window), window->alloc.x, window->alloc.y);
 
   child = gtk_bin_get_child (GTK_BIN (widget));
   if (G_LIKELY (child != NULL))
@@ -1520,7 +1614,6 @@ panel_window_screen_changed (GtkWidget *widget,
                              GdkScreen *previous_screen)
 {
   PanelWindow *window = PANEL_WINDOW (widget);
-  WnckWindow  *wnck_window;
   WnckScreen  *wnck_screen;
   GdkScreen   *screen;
 
@@ -1536,14 +1629,20 @@ panel_window_screen_changed (GtkWidget *widget,
   /* disconnect from previous screen */
   if (G_UNLIKELY (window->screen != NULL))
     g_signal_handlers_disconnect_by_func (G_OBJECT (window->screen),
-        panel_window_screen_layout_changed, window);
+        panel_window_screen_geometry_changed, window);
+
+  /* stop waiting for the previous screen to settle */
+  if (window->layout_settle_id != 0)
+    g_source_remove (window->layout_settle_id);
 
   /* set the new screen */
   window->screen = screen;
+  window->layout_valid = FALSE;
+  window->layout_config = panel_window_screen_layout_hash (screen);
   g_signal_connect (G_OBJECT (window->screen), "monitors-changed",
-      G_CALLBACK (panel_window_screen_layout_changed), window);
+      G_CALLBACK (panel_window_screen_geometry_changed), window);
   g_signal_connect (G_OBJECT (window->screen), "size-changed",
-      G_CALLBACK (panel_window_screen_layout_changed), window);
+      G_CALLBACK (panel_window_screen_geometry_changed), window);
 
   /* set new output name */
   if (gdk_display_get_n_screens (gdk_screen_get_display (screen)) > 1)
@@ -1558,8 +1657,7 @@ panel_window_screen_changed (GtkWidget *widget,
 
   /* update wnck screen to be used for the autohide feature */
   wnck_screen = wnck_screen_get (gdk_screen_get_number (screen));
-  wnck_window = wnck_screen_get_active_window (wnck_screen);
-  panel_window_update_autohide_window (window, wnck_screen, wnck_window);
+  panel_window_update_autohide_window (window, wnck_screen);
 }
 
 
@@ -1590,6 +1688,9 @@ panel_window_realize (GtkWidget *widget)
 
   (*GTK_WIDGET_CLASS (panel_window_parent_class)->realize) (widget);
 
+  /* the new x window has no struts yet, so forget the cached values */
+  memset (window->struts, 0, sizeof (window->struts));
+
   /* set struts if we snap to an edge */
   if (window->struts_edge != STRUTS_EDGE_NONE)
     panel_window_screen_struts_set (window);
@@ -1972,6 +2073,8 @@ panel_window_screen_layout_changed (GdkScreen   *screen,
   gint          screen_num;
   GdkDisplay   *display;
   GdkScreen    *new_screen;
+  LayoutCache  *cache;
+  gpointer      cache_key;
 
   panel_return_if_fail (PANEL_IS_WINDOW (window));
   panel_return_if_fail (GDK_IS_SCREEN (screen));
@@ -1992,6 +2095,25 @@ panel_window_screen_layout_changed (GdkScreen   *screen,
     force_struts_update = TRUE;
   window->struts_edge = struts_edge;
 
+  /* use the working area computed earlier for this monitor configuration
+   * if none of the settings changed since, the configuration is hashed
+   * once when the screen settled, so a lookup does not query monitors */
+  cache_key = GUINT_TO_POINTER (window->layout_config ^ struts_edge);
+  cache = window->layout_settle_id == 0 ?
+    g_hash_table_lookup (window->layout_cache, cache_key) : NULL;
+  if (cache != NULL
+      && cache->config == window->layout_config
+      && cache->struts_edge_in == struts_edge
+      && cache->span_monitors == window->span_monitors
+      && cache->base_x == window->base_x
+      && cache->base_y == window->base_y
+      && g_strcmp0 (cache->output_name, window->output_name) == 0)
+    {
+      a = cache->area;
+      window->struts_edge = cache->struts_edge;
+      goto apply_layout;
+    }
+
   /* get the number of monitors */
   n_monitors = gdk_screen_get_n_monitors (screen);
   panel_return_if_fail (n_monitors > 0);
@@ -2195,6 +2317,53 @@ panel_window_screen_layout_changed (GdkScreen   *screen,
                      "%p: unset struts edge; between monitors", window);
     }
 
+  /* remember the result for this configuration, unless the screen is
+   * still changing and the configuration is not up to date */
+  if (window->layout_settle_id != 0)
+    goto apply_layout;
+
+  if (g_hash_table_size (window->layout_cache) >= LAYOUT_CACHE_SIZE)
+    g_hash_table_remove_all (window->layout_cache);
+
+  cache = g_slice_new0 (LayoutCache);
+  cache->config = window->layout_config;
+  cache->output_name = g_strdup (window->output_name);
+  cache->span_monitors = window->span_monitors;
+  cache->base_x = window->base_x;
+  cache->base_y = window->base_y;
+  cache->struts_edge_in = struts_edge;
+  cache->area = a;
+  cache->struts_edge = window->struts_edge;
+  g_hash_table_replace (window->layout_cache, cache_key, cache);
+
+  apply_layout:
+
+  /* this function runs for every autohide state change, leave when the
+   * layout is the same as the last time, so the window is not moved and
+   * the struts are not written again */
+  if (window->layout_valid
+      && window->layout_struts_edge == window->struts_edge
+      && window->layout_snap_position == window->snap_position
+      && window->layout_mode == window->mode
+      && window->layout_base_x == window->base_x
+      && window->layout_base_y == window->base_y
+      && window->area.x == a.x
+      && window->area.y == a.y
+      && window->area.width == a.width
+      && window->area.height == a.height)
+    {
+      if (!gtk_widget_get_visible (GTK_WIDGET (window)))
+        gtk_widget_show (GTK_WIDGET (window));
+      return;
+    }
+
+  window->layout_valid = TRUE;
+  window->layout_struts_edge = window->struts_edge;
+  window->layout_snap_position = window->snap_position;
+  window->layout_mode = window->mode;
+  window->layout_base_x = window->base_x;
+  window->layout_base_y = window->base_y;
+
   /* set the new working area of the panel */
   window->area = a;
   panel_debug (PANEL_DEBUG_POSITIONING,
@@ -2216,105 +2385,454 @@ panel_window_screen_layout_changed (GdkScreen   *screen,
 
 
 
+static gboolean
+panel_window_screen_layout_settled (gpointer user_data)
+{
+  PanelWindow *window = PANEL_WINDOW (user_data);
+
+  panel_return_val_if_fail (GDK_IS_SCREEN (window->screen), FALSE);
+
+  /* the screen settled, so the layout below can be cached */
+  window->layout_settle_id = 0;
+
+  /* the monitor layout or screen size changed, which also affects the
+   * struts on the bottom and right edges, so always update the layout */
+  window->layout_valid = FALSE;
+  window->layout_config = panel_window_screen_layout_hash (window->screen);
+  panel_window_screen_layout_changed (window->screen, window);
+
+  return FALSE;
+}
+
+
+
+static void
+panel_window_screen_layout_settled_destroyed (gpointer user_data)
+{
+  PANEL_WINDOW (user_data)->layout_settle_id = 0;
+}
+
+
+
+static void
+panel_window_screen_geometry_changed (GdkScreen   *screen,
+                                      PanelWindow *window)
+{
+  panel_return_if_fail (PANEL_IS_WINDOW (window));
+
+  /* randr emits several changes while outputs are (un)plugged, restart
+   * the timeout so only the final configuration updates the layout */
+  if (window->layout_settle_id != 0)
+    g_source_remove (window->layout_settle_id);
+
+  window->layout_settle_id =
+    gdk_threads_add_timeout_full (G_PRIORITY_DEFAULT, LAYOUT_SETTLE_DELAY,
+                                  panel_window_screen_layout_settled, window,
+                                  panel_window_screen_layout_settled_destroyed);
+}
+
+
+
+static guint
+panel_window_screen_layout_hash (GdkScreen *screen)
+{
+  GdkRectangle  geometry;
+  gint          n, n_monitors;
+  guint         hash;
+  gchar        *name;
+
+  panel_return_val_if_fail (GDK_IS_SCREEN (screen), 0);
+
+  /* hash the size, primary monitor and the geometry and output
+   * name of all monitors */
+  n_monitors = gdk_screen_get_n_monitors (screen);
+  hash = gdk_screen_get_number (screen);
+  hash = hash * 31 + gdk_screen_get_width (screen);
+  hash = hash * 31 + gdk_screen_get_height (screen);
+  hash = hash * 31 + gdk_screen_get_primary_monitor (screen);
+  hash = hash * 31 + n_monitors;
+
+  for (n = 0; n < n_monitors; n++)
+    {
+      gdk_screen_get_monitor_geometry (screen, n, &geometry);
+      hash = hash * 31 + geometry.x;
+      hash = hash * 31 + geometry.y;
+      hash = hash * 31 + geometry.width;
+      hash = hash * 31 + geometry.height;
+
+      name = gdk_screen_get_monitor_plug_name (screen, n);
+      if (name != NULL)
+        hash = hash * 31 + g_str_hash (name);
+      g_free (name);
+    }
+
+  return hash;
+}
+
+
+
+static void
+panel_window_layout_cache_free (gpointer data)
+{
+  LayoutCache *cache = data;
+
+  g_free (cache->output_name);
+  g_slice_free (LayoutCache, cache);
+}
+
+
+
 static void
-panel_window_active_window_changed (WnckScreen  *screen,
-                                    WnckWindow  *previous_window,
+panel_window_overlap_schedule (PanelWindow *window)
+{
+  /* window geometries change continuously while they are moved or
+   * resized, so only check the overlap once for each frame */
+  if (window->autohide_evaluate_id == 0)
+    window->autohide_evaluate_id =
+      gtk_widget_add_tick_callback (GTK_WIDGET (window),
+                                    panel_window_overlap_tick,
+                                    NULL, NULL);
+}
+
+
+
+static void
+panel_window_overlap_window_queue (PanelWindow   *window,
+                                   OverlapWindow *overlap)
+{
+  if (!overlap->queued)
+    {
+      overlap->queued = TRUE;
+      g_queue_push_tail (window->overlap_queue, overlap);
+    }
+
+  panel_window_overlap_schedule (window);
+}
+
+
+
+static void
+panel_window_overlap_window_changed (WnckWindow  *wnck_window,
+                                     PanelWindow *window)
+{
+  OverlapWindow *overlap;
+
+  panel_return_if_fail (WNCK_IS_WINDOW (wnck_window));
+  panel_return_if_fail (PANEL_IS_WINDOW (window));
+
+  overlap = g_hash_table_lookup (window->overlap_windows,
+      GSIZE_TO_POINTER (wnck_window_get_xid (wnck_window)));
+  if (G_LIKELY (overlap != NULL))
+    panel_window_overlap_window_queue (window, overlap);
+}
+
+
+
+static void
+panel_window_overlap_window_state_changed (WnckWindow      *wnck_window,
+                                           WnckWindowState  changed,
+                                           WnckWindowState  new,
+                                           PanelWindow     *window)
+{
+  panel_return_if_fail (WNCK_IS_WINDOW (wnck_window));
+
+  if (changed & (WNCK_WINDOW_STATE_SHADED
+                 | WNCK_WINDOW_STATE_MINIMIZED
+                 | WNCK_WINDOW_STATE_HIDDEN))
+    panel_window_overlap_window_changed (wnck_window, window);
+}
+
+
+
+static void
+panel_window_overlap_window_opened (WnckScreen  *screen,
+                                    WnckWindow  *wnck_window,
                                     PanelWindow *window)
 {
-  WnckWindow *active_window;
+  OverlapWindow *overlap;
 
-  panel_return_if_fail (WNCK_IS_SCREEN (screen));
+  panel_return_if_fail (WNCK_IS_WINDOW (wnck_window));
   panel_return_if_fail (PANEL_IS_WINDOW (window));
 
-  /* obtain new active window from the screen */
-  active_window = wnck_screen_get_active_window (screen);
+  overlap = g_slice_new0 (OverlapWindow);
+  overlap->wnck_window = wnck_window;
+  overlap->frame_extents_height = -1;
+  g_hash_table_insert (window->overlap_windows,
+      GSIZE_TO_POINTER (wnck_window_get_xid (wnck_window)), overlap);
+
+  g_signal_connect (G_OBJECT (wnck_window), "geometry-changed",
+      G_CALLBACK (panel_window_overlap_window_changed), window);
+  g_signal_connect (G_OBJECT (wnck_window), "workspace-changed",
+      G_CALLBACK (panel_window_overlap_window_changed), window);
+  g_signal_connect (G_OBJECT (wnck_window), "state-changed",
+      G_CALLBACK (panel_window_overlap_window_state_changed), window);
+
+  panel_window_overlap_window_queue (window, overlap);
+}
+
+
+
+static void
+panel_window_overlap_window_free (PanelWindow   *window,
+                                  OverlapWindow *overlap)
+{
+  g_signal_handlers_disconnect_by_func (overlap->wnck_window,
+      panel_window_overlap_window_changed, window);
+  g_signal_handlers_disconnect_by_func (overlap->wnck_window,
+      panel_window_overlap_window_state_changed, window);
+
+  if (overlap->queued)
+    g_queue_remove (window->overlap_queue, overlap);
+
+  if (overlap->overlaps)
+    {
+      panel_assert (window->overlap_count > 0);
+      window->overlap_count--;
+    }
 
-  /* update the active window to be used for the autohide feature */
-  panel_window_update_autohide_window (window, screen, active_window);
+  g_slice_free (OverlapWindow, overlap);
 }
 
 
 
 static void
-panel_window_active_window_geometry_changed (WnckWindow  *active_window,
-                                             PanelWindow *window)
+panel_window_overlap_window_closed (WnckScreen  *screen,
+                                    WnckWindow  *wnck_window,
+                                    PanelWindow *window)
 {
-  GdkRectangle panel_area;
-  GdkRectangle window_area;
+  OverlapWindow *overlap;
+  gpointer       xid;
 
-  panel_return_if_fail (WNCK_IS_WINDOW (active_window));
+  panel_return_if_fail (WNCK_IS_WINDOW (wnck_window));
   panel_return_if_fail (PANEL_IS_WINDOW (window));
 
-  /* ignore if for some reason the active window does not match the one we know */
-  if (G_UNLIKELY (window->wnck_active_window != active_window))
+  xid = GSIZE_TO_POINTER (wnck_window_get_xid (wnck_window));
+  overlap = g_hash_table_lookup (window->overlap_windows, xid);
+  if (G_UNLIKELY (overlap == NULL))
     return;
 
-  /* only react to active window geometry changes if we are doing
-   * intelligent autohiding */
+  g_hash_table_remove (window->overlap_windows, xid);
+  panel_window_overlap_window_free (window, overlap);
+
+  /* the panel might be uncovered now */
+  panel_window_overlap_schedule (window);
+}
+
+
+
+static void
+panel_window_overlap_workspace_changed (WnckScreen    *screen,
+                                        WnckWorkspace *previous_workspace,
+                                        PanelWindow   *window)
+{
+  panel_return_if_fail (PANEL_IS_WINDOW (window));
+
+  /* the visibility of all windows changed */
+  window->overlap_rescan = TRUE;
+  panel_window_overlap_schedule (window);
+}
+
+
+
+#ifdef GDK_WINDOWING_X11
+static GdkFilterReturn
+panel_window_frame_extents_filter (GdkXEvent *xevent,
+                                   GdkEvent  *event,
+                                   gpointer   data)
+{
+  PanelWindow   *window = PANEL_WINDOW (data);
+  XEvent        *xev = (XEvent *) xevent;
+  OverlapWindow *overlap;
+
+  /* invalidate the cached frame extents of a tracked window, wnck
+   * already selected property changes on all client windows */
+  if (xev->type == PropertyNotify
+      && xev->xproperty.atom == net_frame_extents_atom
+      && window->overlap_windows != NULL)
+    {
+      overlap = g_hash_table_lookup (window->overlap_windows,
+                                     GSIZE_TO_POINTER (xev->xproperty.window));
+      if (overlap != NULL)
+        {
+          overlap->frame_extents_height = -1;
+          panel_window_overlap_window_queue (window, overlap);
+        }
+    }
+
+  return GDK_FILTER_CONTINUE;
+}
+
+
+
+static gint
+panel_window_frame_extents_height (OverlapWindow *overlap)
+{
+  GdkDisplay    *display;
+  Atom           real_type;
+  int            real_format;
+  unsigned long  items_read, items_left;
+  gulong        *data = NULL;
+
+  if (overlap->frame_extents_height >= 0)
+    return overlap->frame_extents_height;
+
+  display = gdk_display_get_default ();
+  if (!GDK_IS_X11_DISPLAY (display))
+    return -1;
+
+  gdk_error_trap_push ();
+  if (XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display),
+                          wnck_window_get_xid (overlap->wnck_window),
+                          net_frame_extents_atom,
+                          0, 4, FALSE, XA_CARDINAL,
+                          &real_type, &real_format, &items_read, &items_left,
+                          (unsigned char **) &data) == Success
+      && real_format == 32
+      && items_read >= 4)
+    overlap->frame_extents_height = data[2] + data[3];
+  gdk_error_trap_pop_ignored ();
+
+  if (data != NULL)
+    XFree (data);
+
+  return overlap->frame_extents_height;
+}
+#endif
+
+
+
+static void
+panel_window_overlap_window_update (PanelWindow   *window,
+                                    OverlapWindow *overlap,
+                                    WnckWorkspace *workspace)
+{
+  WnckWindow     *wnck_window = overlap->wnck_window;
+  WnckWindowType  type;
+  GdkRectangle    window_area;
+  gboolean        overlaps = FALSE;
+#ifdef GDK_WINDOWING_X11
+  gint            height;
+#endif
+
+  overlap->queued = FALSE;
+
+  /* only visible normal windows on the current workspace cover the
+   * panel, desktops and other panels or docks are ignored */
+  type = wnck_window_get_window_type (wnck_window);
+  if (type != WNCK_WINDOW_DESKTOP
+      && type != WNCK_WINDOW_DOCK
+      && (workspace != NULL
+          ? wnck_window_is_visible_on_workspace (wnck_window, workspace)
+          : !wnck_window_is_minimized (wnck_window)))
+    {
+      wnck_window_get_geometry (wnck_window,
+                                &window_area.x, &window_area.y,
+                                &window_area.width, &window_area.height);
+
+#ifdef GDK_WINDOWING_X11
+      /* if a window is shaded, check the height of the window's
+       * decoration as exposed through the _NET_FRAME_EXTENTS application
+       * window property */
+      if (wnck_window_is_shaded (wnck_window))
+        {
+          height = panel_window_frame_extents_height (overlap);
+          if (height >= 0)
+            window_area.height = height;
+        }
+#endif
+
+      overlaps = gdk_rectangle_intersect (&window->overlap_area, &window_area, NULL);
+    }
+
+  /* keep the number of overlapping windows up-to-date, so the panel
+   * never has to walk all windows to decide whether it is covered */
+  if (overlap->overlaps != overlaps)
+    {
+      overlap->overlaps = overlaps;
+      if (overlaps)
+        window->overlap_count++;
+      else
+        window->overlap_count--;
+    }
+}
+
+
+
+static gboolean
+panel_window_overlap_tick (GtkWidget     *widget,
+                           GdkFrameClock *frame_clock,
+                           gpointer       user_data)
+{
+  PanelWindow *window = PANEL_WINDOW (widget);
+
+  window->autohide_evaluate_id = 0;
+  panel_window_autohide_evaluate (window);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+
+static void
+panel_window_autohide_evaluate (PanelWindow *window)
+{
+  GdkRectangle    panel_area;
+  WnckWorkspace  *workspace;
+  OverlapWindow  *overlap;
+  GHashTableIter  iter;
+
+  panel_return_if_fail (PANEL_IS_WINDOW (window));
+
+  if (window->overlap_windows == NULL)
+    return;
+
+  /* obtain position and dimension from the panel */
+  panel_window_size_allocate_set_xy (window,
+                                     window->alloc.width,
+                                     window->alloc.height,
+                                     &panel_area.x,
+                                     &panel_area.y);
+  gtk_window_get_size (GTK_WINDOW (window),
+                       &panel_area.width,
+                       &panel_area.height);
+
+  workspace = wnck_screen_get_active_workspace (window->wnck_screen);
+
+  if (window->overlap_rescan
+      || panel_area.x != window->overlap_area.x
+      || panel_area.y != window->overlap_area.y
+      || panel_area.width != window->overlap_area.width
+      || panel_area.height != window->overlap_area.height)
+    {
+      /* the panel moved or the workspace changed, check all windows */
+      window->overlap_area = panel_area;
+      window->overlap_rescan = FALSE;
+      g_queue_clear (window->overlap_queue);
+
+      g_hash_table_iter_init (&iter, window->overlap_windows);
+      while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &overlap))
+        panel_window_overlap_window_update (window, overlap, workspace);
+    }
+  else
+    {
+      /* only check the windows that changed since the last time */
+      while ((overlap = g_queue_pop_head (window->overlap_queue)) != NULL)
+        panel_window_overlap_window_update (window, overlap, workspace);
+    }
+
+  /* show/hide the panel, depending on whether any window on the current
+   * workspace overlaps with its coordinates */
   if (window->autohide_behavior == AUTOHIDE_BEHAVIOR_INTELLIGENTLY
       && window->autohide_block == 0)
     {
-      if (wnck_window_get_window_type (active_window) != WNCK_WINDOW_DESKTOP)
+      if (window->autohide_state != AUTOHIDE_HIDDEN)
         {
-          /* obtain position and dimensions from the active window */
-          wnck_window_get_geometry (active_window,
-                                    &window_area.x, &window_area.y,
-                                    &window_area.width, &window_area.height);
-
-          /* if a window is shaded, check the height of the window's
-           * decoration as exposed through the _NET_FRAME_EXTENTS application
-           * window property */
-          if (wnck_window_is_shaded (active_window))
-          {
-            Display *display;
-            Atom real_type;
-            int real_format;
-            unsigned long items_read, items_left;
-            guint32 *data;
-
-            display = GDK_DISPLAY_XDISPLAY (gdk_display_get_default ());
-            if (XGetWindowProperty (display, wnck_window_get_xid (active_window),
-                                    XInternAtom(display, "_NET_FRAME_EXTENTS", True),
-                                    0, 4, FALSE, AnyPropertyType,
-                                    &real_type, &real_format, &items_read, &items_left,
-                                    (unsigned char **) &data) == Success
-                                    && (items_read >= 4))
-              window_area.height = data[2] + data[3];
-
-            if (data)
-            {
-              XFree (data);
-            }
-          }
-
-          /* obtain position and dimension from the panel */
-          panel_window_size_allocate_set_xy (window,
-                                             window->alloc.width,
-                                             window->alloc.height,
-                                             &panel_area.x,
-                                             &panel_area.y);
-          gtk_window_get_size (GTK_WINDOW (window),
-                               &panel_area.width,
-                               &panel_area.height);
-
-          /* show/hide the panel, depending on whether the active window overlaps
-           * with its coordinates */
-          if (window->autohide_state != AUTOHIDE_HIDDEN)
-            {
-              if (gdk_rectangle_intersect (&panel_area,  &window_area, NULL))
-                panel_window_autohide_queue (window, AUTOHIDE_HIDDEN);
-            }
-          else
-            {
-              if (!gdk_rectangle_intersect (&panel_area, &window_area, NULL))
-                panel_window_autohide_queue (window, AUTOHIDE_VISIBLE);
-            }
+          if (window->overlap_count > 0)
+            panel_window_autohide_queue (window, AUTOHIDE_HIDDEN);
         }
       else
         {
-          /* make the panel visible if it isn't at the moment and the active
-           * window is the desktop */
-          if (window->autohide_state != AUTOHIDE_VISIBLE)
+          if (window->overlap_count == 0)
             panel_window_autohide_queue (window, AUTOHIDE_VISIBLE);
         }
     }
@@ -2323,15 +2841,255 @@ panel_window_active_window_geometry_changed (WnckWindow  *active_window,
 
 
 static void
-panel_window_active_window_state_changed (WnckWindow  *active_window,
-                                          WnckWindowState changed,
-                                          WnckWindowState new,
-                                          PanelWindow *window)
+panel_window_overlap_start (PanelWindow *window)
+{
+  GList      *li;
+#ifdef GDK_WINDOWING_X11
+  GdkDisplay *display;
+#endif
+
+  panel_return_if_fail (WNCK_IS_SCREEN (window->wnck_screen));
+  panel_return_if_fail (window->overlap_windows == NULL);
+
+  window->overlap_windows = g_hash_table_new (g_direct_hash, g_direct_equal);
+  window->overlap_queue = g_queue_new ();
+  window->overlap_count = 0;
+  window->overlap_rescan = TRUE;
+
+  g_signal_connect (G_OBJECT (window->wnck_screen), "window-opened",
+      G_CALLBACK (panel_window_overlap_window_opened), window);
+  g_signal_connect (G_OBJECT (window->wnck_screen), "window-closed",
+      G_CALLBACK (panel_window_overlap_window_closed), window);
+  g_signal_connect (G_OBJECT (window->wnck_screen), "active-workspace-changed",
+      G_CALLBACK (panel_window_overlap_workspace_changed), window);
+
+  for (li = wnck_screen_get_windows (window->wnck_screen); li != NULL; li = li->next)
+    panel_window_overlap_window_opened (window->wnck_screen, li->data, window);
+
+#ifdef GDK_WINDOWING_X11
+  /* watch frame extent changes for shaded windows */
+  display = gdk_display_get_default ();
+  if (GDK_IS_X11_DISPLAY (display))
+    {
+      if (net_frame_extents_atom == None)
+        net_frame_extents_atom = gdk_x11_get_xatom_by_name_for_display (display, "_NET_FRAME_EXTENTS");
+      gdk_window_add_filter (NULL, panel_window_frame_extents_filter, window);
+    }
+#endif
+}
+
+
+
+static void
+panel_window_overlap_stop (PanelWindow *window)
+{
+  GHashTableIter  iter;
+  OverlapWindow  *overlap;
+
+  panel_return_if_fail (window->overlap_windows != NULL);
+
+#ifdef GDK_WINDOWING_X11
+  gdk_window_remove_filter (NULL, panel_window_frame_extents_filter, window);
+#endif
+
+  g_signal_handlers_disconnect_by_func (window->wnck_screen,
+      panel_window_overlap_window_opened, window);
+  g_signal_handlers_disconnect_by_func (window->wnck_screen,
+      panel_window_overlap_window_closed, window);
+  g_signal_handlers_disconnect_by_func (window->wnck_screen,
+      panel_window_overlap_workspace_changed, window);
+
+  g_hash_table_iter_init (&iter, window->overlap_windows);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &overlap))
+    {
+      g_hash_table_iter_remove (&iter);
+      panel_window_overlap_window_free (window, overlap);
+    }
+
+  g_hash_table_destroy (window->overlap_windows);
+  window->overlap_windows = NULL;
+  g_queue_free (window->overlap_queue);
+  window->overlap_queue = NULL;
+  window->overlap_count = 0;
+
+  if (window->autohide_evaluate_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (window),
+                                       window->autohide_evaluate_id);
+      window->autohide_evaluate_id = 0;
+    }
+}
+
+
+
+static gboolean
+panel_window_autohide_slide_offset (PanelWindow *window,
+                                    gint        *dx,
+                                    gint        *dy)
+{
+  *dx = *dy = 0;
+
+  /* slide the panel towards the screen edge it is snapped to */
+  switch (window->snap_position)
+    {
+    case SNAP_POSITION_NONE:
+      return FALSE;
+
+    case SNAP_POSITION_N:
+    case SNAP_POSITION_NC:
+      *dy = -window->alloc.height;
+      break;
+
+    case SNAP_POSITION_S:
+    case SNAP_POSITION_SC:
+      *dy = window->alloc.height;
+      break;
+
+    case SNAP_POSITION_E:
+    case SNAP_POSITION_EC:
+      *dx = window->alloc.width;
+      break;
+
+    case SNAP_POSITION_W:
+    case SNAP_POSITION_WC:
+      *dx = -window->alloc.width;
+      break;
+
+    case SNAP_POSITION_NE:
+      if (IS_HORIZONTAL (window))
+        *dy = -window->alloc.height;
+      else
+        *dx = window->alloc.width;
+      break;
+
+    case SNAP_POSITION_SE:
+      if (IS_HORIZONTAL (window))
+        *dy = window->alloc.height;
+      else
+        *dx = window->alloc.width;
+      break;
+
+    case SNAP_POSITION_NW:
+      if (IS_HORIZONTAL (window))
+        *dy = -window->alloc.height;
+      else
+        *dx = -window->alloc.width;
+      break;
+
+    case SNAP_POSITION_SW:
+      if (IS_HORIZONTAL (window))
+        *dy = window->alloc.height;
+      else
+        *dx = -window->alloc.width;
+      break;
+    }
+
+  return TRUE;
+}
+
+
+
+static void
+panel_window_autohide_slide_move (PanelWindow *window)
+{
+  gint            dx, dy;
+  gint            x, y;
+  cairo_region_t *region;
+
+  panel_window_autohide_slide_offset (window, &dx, &dy);
+
+  x = window->alloc.x + (gint) (dx * window->autohide_slide_progress);
+  y = window->alloc.y + (gint) (dy * window->autohide_slide_progress);
+
+  /* clip the panel to its working area, so it does not slide onto
+   * the neighbouring monitor */
+  region = cairo_region_create_rectangle (&window->area);
+  cairo_region_translate (region, -x, -y);
+  gtk_widget_shape_combine_region (GTK_WIDGET (window), region);
+  cairo_region_destroy (region);
+
+  /* only move the toplevel, the allocation is not touched during the
+   * animation, so this is cheap on every frame */
+  gtk_window_move (GTK_WINDOW (window), x, y);
+}
+
+
+
+static gboolean
+panel_window_autohide_slide_tick (GtkWidget     *widget,
+                                  GdkFrameClock *frame_clock,
+                                  gpointer       user_data)
 {
-  panel_return_if_fail (WNCK_IS_WINDOW (active_window));
+  PanelWindow *window = PANEL_WINDOW (widget);
+  gdouble      t;
+
+  /* the last frame time can be old when the clock was idle, so the
+   * animation starts with the first frame */
+  if (window->autohide_slide_start == 0)
+    window->autohide_slide_start = gdk_frame_clock_get_frame_time (frame_clock);
+
+  t = (gdouble) (gdk_frame_clock_get_frame_time (frame_clock)
+                 - window->autohide_slide_start)
+      / (SLIDE_DURATION * 1000);
+  t = CLAMP (t, 0.0, 1.0);
+
+  /* ease out cubic */
+  t = 1.0 - (1.0 - t) * (1.0 - t) * (1.0 - t);
+  window->autohide_slide_progress = window->autohide_slide_in ? 1.0 - t : t;
+
+  panel_window_autohide_slide_move (window);
 
-  if (changed & WNCK_WINDOW_STATE_SHADED)
-    panel_window_active_window_geometry_changed (active_window, window);
+  if (t < 1.0)
+    return G_SOURCE_CONTINUE;
+
+  window->autohide_slide_id = 0;
+  gtk_widget_shape_combine_region (widget, NULL);
+
+  /* move the windows to their hidden positions */
+  if (!window->autohide_slide_in)
+    gtk_widget_queue_resize (GTK_WIDGET (window));
+
+  return G_SOURCE_REMOVE;
+}
+
+
+
+static gboolean
+panel_window_autohide_slide_start (PanelWindow *window,
+                                   gboolean     slide_in)
+{
+  gint dx, dy;
+
+  panel_window_autohide_slide_stop (window);
+
+  if (!gtk_widget_get_mapped (GTK_WIDGET (window))
+      || !panel_window_autohide_slide_offset (window, &dx, &dy))
+    return FALSE;
+
+  window->autohide_slide_in = !!slide_in;
+  window->autohide_slide_progress = slide_in ? 1.0 : 0.0;
+  window->autohide_slide_start = 0;
+  window->autohide_slide_id =
+    gtk_widget_add_tick_callback (GTK_WIDGET (window),
+                                  panel_window_autohide_slide_tick,
+                                  NULL, NULL);
+
+  return TRUE;
+}
+
+
+
+static void
+panel_window_autohide_slide_stop (PanelWindow *window)
+{
+  if (window->autohide_slide_id != 0)
+    {
+      gtk_widget_remove_tick_callback (GTK_WIDGET (window),
+                                       window->autohide_slide_id);
+      window->autohide_slide_id = 0;
+
+      gtk_widget_shape_combine_region (GTK_WIDGET (window), NULL);
+    }
 }
 
 
@@ -2347,9 +3105,20 @@ panel_window_autohide_timeout (gpointer user_data)
   /* update the status */
   if (window->autohide_state == AUTOHIDE_POPDOWN
       || window->autohide_state == AUTOHIDE_POPDOWN_SLOW)
-    window->autohide_state = AUTOHIDE_HIDDEN;
+    {
+      window->autohide_state = AUTOHIDE_HIDDEN;
+
+      /* slide the panel out, the windows are moved when it finishes */
+      if (panel_window_autohide_slide_start (window, FALSE))
+        return FALSE;
+    }
   else if (window->autohide_state == AUTOHIDE_POPUP)
-    window->autohide_state = AUTOHIDE_VISIBLE;
+    {
+      window->autohide_state = AUTOHIDE_VISIBLE;
+
+      /* slide the panel in from its allocated position */
+      panel_window_autohide_slide_start (window, TRUE);
+    }
 
   /* move the windows around */
   gtk_widget_queue_resize (GTK_WIDGET (window));
@@ -2379,6 +3148,13 @@ panel_window_autohide_queue (PanelWindow   *window,
   if (window->autohide_timeout_id != 0)
     g_source_remove (window->autohide_timeout_id);
 
+  /* abort a running slide, the resize puts the panel in place */
+  if (window->autohide_slide_id != 0)
+    {
+      panel_window_autohide_slide_stop (window);
+      gtk_widget_queue_resize (GTK_WIDGET (window));
+    }
+
   /* set new autohide state */
   window->autohide_state = new_state;
 
@@ -2394,6 +3170,19 @@ panel_window_autohide_queue (PanelWindow   *window,
     }
   else
     {
+      /* intelligent hiding sets these states directly, slide or move
+       * the panel now, the layout update above skips the resize when the
+       * working area did not change */
+      if (new_state == AUTOHIDE_HIDDEN || new_state == AUTOHIDE_VISIBLE)
+        {
+          /* the windows are moved when the slide out finishes */
+          if (!panel_window_autohide_slide_start (window, new_state == AUTOHIDE_VISIBLE)
+              || new_state == AUTOHIDE_VISIBLE)
+            gtk_widget_queue_resize (GTK_WIDGET (window));
+
+          return;
+        }
+
       /* timeout delay */
       if (new_state == AUTOHIDE_POPDOWN)
         delay = window->popdown_delay;
@@ -2490,6 +3279,9 @@ panel_window_set_autohide_behavior (PanelWindow *window,
   /* remember the new behavior */
   window->autohide_behavior = behavior;
 
+  /* start or stop tracking the windows for intelligent autohiding */
+  panel_window_update_autohide_window (window, window->wnck_screen);
+
     /* create an autohide window only if we are autohiding at all */
     if (window->autohide_behavior != AUTOHIDE_BEHAVIOR_NEVER)
     {
@@ -2578,61 +3370,30 @@ panel_window_set_autohide_behavior (PanelWindow *window,
 
 static void
 panel_window_update_autohide_window (PanelWindow *window,
-                                     WnckScreen  *screen,
-                                     WnckWindow  *active_window)
+                                     WnckScreen  *screen)
 {
   panel_return_if_fail (PANEL_IS_WINDOW (window));
   panel_return_if_fail (screen == NULL || WNCK_IS_SCREEN (screen));
-  panel_return_if_fail (active_window == NULL || WNCK_IS_WINDOW (active_window));
 
-  /* update current screen */
-  if (screen != window->wnck_screen)
-    {
-      /* disconnect from previous screen */
-      if (G_LIKELY (window->wnck_screen != NULL))
-        {
-          g_signal_handlers_disconnect_by_func (window->wnck_screen,
-              panel_window_active_window_changed, window);
-        }
+  /* stop tracking the windows of the previous screen */
+  if (screen != window->wnck_screen
+      && window->overlap_windows != NULL)
+    panel_window_overlap_stop (window);
 
-      /* remember new screen */
-      window->wnck_screen = screen;
+  /* remember new screen */
+  window->wnck_screen = screen;
 
-      /* connect to the new screen */
-      if (screen != NULL)
-        {
-          g_signal_connect (G_OBJECT (screen), "active-window-changed",
-              G_CALLBACK (panel_window_active_window_changed), window);
-        }
+  /* only track the windows on the screen if we are doing intelligent
+   * autohiding */
+  if (window->autohide_behavior == AUTOHIDE_BEHAVIOR_INTELLIGENTLY
+      && screen != NULL)
+    {
+      if (window->overlap_windows == NULL)
+        panel_window_overlap_start (window);
     }
-
-  /* update active window */
-  if (G_LIKELY (active_window != window->wnck_active_window))
+  else if (window->overlap_windows != NULL)
     {
-      /* disconnect from previously active window */
-      if (G_LIKELY (window->wnck_active_window != NULL))
-        {
-          g_signal_handlers_disconnect_by_func (window->wnck_active_window,
-              panel_window_active_window_geometry_changed, window);
-          g_signal_handlers_disconnect_by_func (window->wnck_active_window,
-              panel_window_active_window_state_changed, window);
-        }
-
-      /* remember the new window */
-      window->wnck_active_window = active_window;
-
-      /* connect to the new window but only if it is not a desktop/root-type window */
-      if (active_window != NULL)
-        {
-          g_signal_connect (G_OBJECT (active_window), "geometry-changed",
-              G_CALLBACK (panel_window_active_window_geometry_changed), window);
-          g_signal_connect (G_OBJECT (active_window), "state-changed",
-              G_CALLBACK (panel_window_active_window_state_changed), window);
-
-          /* simulate a geometry change for immediate hiding when the new active
-           * window already overlaps the panel */
-          panel_window_active_window_geometry_changed (active_window, window);
-        }
+      panel_window_overlap_stop (window);
     }
 }
 
@@ -3031,11 +3792,6 @@ panel_window_set_povider_info (PanelWindow *window,
           /* unset the background (PROVIDER_PROP_TYPE_ACTION_BACKGROUND_UNSET) */
           panel_plugin_external_set_background_color (PANEL_PLUGIN_EXTERNAL (provider), NULL);
         }
-      if (base_window->leave_opacity != 1.0)
-        {
-          panel_plugin_external_set_opacity (PANEL_PLUGIN_EXTERNAL (provider),
-              base_window->leave_opacity);
-        }
     }
 
   panel_window_plugin_set_mode (provider, window);
@@ -3073,9 +3829,9 @@ panel_window_thaw_autohide (PanelWindow *window)
 
   if (window->autohide_block == 0
       && window->autohide_state != AUTOHIDE_DISABLED) {
-    /* simulate a geometry change to check for overlapping windows with intelligent hiding */
+    /* check for overlapping windows with intelligent hiding */
     if (window->autohide_behavior == AUTOHIDE_BEHAVIOR_INTELLIGENTLY)
-      panel_window_active_window_geometry_changed (window->wnck_active_window, window);
+      panel_window_autohide_evaluate (window);
     /* otherwise just hide the panel */
     else
       panel_window_autohide_queue (window, AUTOHIDE_POPDOWN);
@@ -37,6 +37,9 @@ static void     xfce_clock_digital_get_property (GObject               *object,
                                                  GValue                *value,
                                                  GParamSpec            *pspec);
 static void     xfce_clock_digital_finalize     (GObject               *object);
+static gboolean xfce_clock_digital_draw         (GtkWidget             *widget,
+                                                 cairo_t               *cr);
+static void     xfce_clock_digital_style_updated (GtkWidget            *widget);
 static gboolean xfce_clock_digital_update       (XfceClockDigital      *digital,
                                                  ClockTime             *time);
 
@@ -63,7 +66,19 @@ struct _XfceClockDigital
   ClockTime          *time;
   ClockTimeTimeout   *timeout;
 
-  gchar *format;
+  gchar            *format;
+  ClockTimeFormat  *compiled;
+
+  /* the rendered markup and the one shown in the layout */
+  GString          *buffer;
+  GString          *markup;
+  PangoLayout      *layout;
+
+  /* widest markup seen, set on the label for a stable size request */
+  GString          *template;
+  GString          *checked;
+  gint              template_width;
+  gchar             widest_digit;
 };
 
 
@@ -75,13 +90,18 @@ XFCE_PANEL_DEFINE_TYPE (XfceClockDigital, xfce_clock_digital, GTK_TYPE_LABEL)
 static void
 xfce_clock_digital_class_init (XfceClockDigitalClass *klass)
 {
-  GObjectClass *gobject_class;
+  GObjectClass   *gobject_class;
+  GtkWidgetClass *gtkwidget_class;
 
   gobject_class = G_OBJECT_CLASS (klass);
   gobject_class->finalize = xfce_clock_digital_finalize;
   gobject_class->set_property = xfce_clock_digital_set_property;
   gobject_class->get_property = xfce_clock_digital_get_property;
 
+  gtkwidget_class = GTK_WIDGET_CLASS (klass);
+  gtkwidget_class->draw = xfce_clock_digital_draw;
+  gtkwidget_class->style_updated = xfce_clock_digital_style_updated;
+
   g_object_class_install_property (gobject_class,
                                    PROP_SIZE_RATIO,
                                    g_param_spec_double ("size-ratio", NULL, NULL,
@@ -107,10 +127,35 @@ xfce_clock_digital_class_init (XfceClockDigitalClass *klass)
 
 
 
+static void
+xfce_clock_digital_reset (XfceClockDigital *digital)
+{
+  /* forget the size template and rendered markup, so the next
+   * update measures the new format or font again */
+  g_string_truncate (digital->markup, 0);
+  g_string_truncate (digital->template, 0);
+  g_string_truncate (digital->checked, 0);
+  digital->template_width = 0;
+  digital->widest_digit = '\0';
+
+  if (digital->layout != NULL)
+    {
+      g_object_unref (G_OBJECT (digital->layout));
+      digital->layout = NULL;
+    }
+}
+
+
+
 static void
 xfce_clock_digital_init (XfceClockDigital *digital)
 {
   digital->format = g_strdup (DEFAULT_DIGITAL_FORMAT);
+  digital->compiled = clock_time_format_new (digital->format);
+  digital->buffer = g_string_sized_new (64);
+  digital->markup = g_string_sized_new (64);
+  digital->template = g_string_sized_new (64);
+  digital->checked = g_string_sized_new (64);
 
   gtk_label_set_justify (GTK_LABEL (digital), GTK_JUSTIFY_CENTER);
 }
@@ -136,6 +181,9 @@ xfce_clock_digital_set_property (GObject      *object,
     case PROP_DIGITAL_FORMAT:
       g_free (digital->format);
       digital->format = g_value_dup_string (value);
+      clock_time_format_free (digital->compiled);
+      digital->compiled = clock_time_format_new (digital->format);
+      xfce_clock_digital_reset (digital);
       break;
 
     default:
@@ -186,25 +234,144 @@ xfce_clock_digital_finalize (GObject *object)
   clock_time_timeout_free (digital->timeout);
 
   g_free (digital->format);
+  clock_time_format_free (digital->compiled);
+  g_string_free (digital->buffer, TRUE);
+  g_string_free (digital->markup, TRUE);
+  g_string_free (digital->template, TRUE);
+  g_string_free (digital->checked, TRUE);
+
+  if (digital->layout != NULL)
+    g_object_unref (G_OBJECT (digital->layout));
 
   (*G_OBJECT_CLASS (xfce_clock_digital_parent_class)->finalize) (object);
 }
 
 
 
+static gboolean
+xfce_clock_digital_draw (GtkWidget *widget,
+                         cairo_t   *cr)
+{
+  XfceClockDigital *digital = XFCE_CLOCK_DIGITAL (widget);
+
+  if (G_UNLIKELY (digital->layout == NULL))
+    return (*GTK_WIDGET_CLASS (xfce_clock_digital_parent_class)->draw) (widget, cr);
+
+  return clock_plugin_label_draw (widget, digital->layout, cr);
+}
+
+
+
+static void
+xfce_clock_digital_style_updated (GtkWidget *widget)
+{
+  XfceClockDigital *digital = XFCE_CLOCK_DIGITAL (widget);
+
+  (*GTK_WIDGET_CLASS (xfce_clock_digital_parent_class)->style_updated) (widget);
+
+  /* not constructed yet */
+  if (digital->time == NULL)
+    return;
+
+  /* the font might have changed */
+  xfce_clock_digital_reset (digital);
+  xfce_clock_digital_update (digital, digital->time);
+}
+
+
+
+static void
+xfce_clock_digital_update_template (XfceClockDigital *digital)
+{
+  GString     *candidate = digital->buffer;
+  const gchar *p;
+  gchar        digit[2] = { '\0', '\0' };
+  gint         width, widest = -1;
+  gboolean     in_tag = FALSE, in_entity = FALSE;
+
+  /* find the widest digit in the current font */
+  if (G_UNLIKELY (digital->widest_digit == '\0'))
+    {
+      for (digit[0] = '0'; digit[0] <= '9'; digit[0]++)
+        {
+          width = clock_plugin_label_measure (GTK_WIDGET (digital), digit);
+          if (width > widest)
+            {
+              widest = width;
+              digital->widest_digit = digit[0];
+            }
+        }
+    }
+
+  /* replace all the digits in the text with the widest one, so
+   * the template only changes when the non-numeric text changes */
+  g_string_truncate (candidate, 0);
+  for (p = digital->markup->str; *p != '\0'; p++)
+    {
+      if (*p == '<')
+        in_tag = TRUE;
+      else if (*p == '>')
+        in_tag = FALSE;
+      else if (*p == '&' && !in_tag)
+        in_entity = TRUE;
+      else if (*p == ';')
+        in_entity = FALSE;
+
+      if (!in_tag && !in_entity && g_ascii_isdigit (*p))
+        g_string_append_c (candidate, digital->widest_digit);
+      else
+        g_string_append_c (candidate, *p);
+    }
+
+  if (g_string_equal (candidate, digital->checked))
+    return;
+  g_string_assign (digital->checked, candidate->str);
+
+  /* only grow the label, a narrower text is drawn inside the
+   * current size request */
+  width = clock_plugin_label_measure (GTK_WIDGET (digital), candidate->str);
+  if (digital->template->len > 0
+      && width <= digital->template_width)
+    return;
+
+  g_string_assign (digital->template, candidate->str);
+  digital->template_width = width;
+
+  gtk_label_set_markup (GTK_LABEL (digital), digital->template->str);
+}
+
+
+
 static gboolean
 xfce_clock_digital_update (XfceClockDigital *digital,
                            ClockTime        *time)
 {
-  gchar            *string;
+  GString          *swap;
 
   panel_return_val_if_fail (XFCE_CLOCK_IS_DIGITAL (digital), FALSE);
   panel_return_val_if_fail (XFCE_IS_CLOCK_TIME (time), FALSE);
 
-  /* set time string */
-  string = clock_time_strdup_strftime (digital->time, digital->format);
-  gtk_label_set_markup (GTK_LABEL (digital), string);
-  g_free (string);
+  /* render the time string and only update the layout if it changed,
+   * this avoids reparsing the markup on every tick */
+  clock_time_format_render (digital->compiled, digital->time, digital->buffer);
+  if (g_string_equal (digital->buffer, digital->markup))
+    return TRUE;
+
+  if (digital->layout == NULL)
+    {
+      digital->layout = gtk_widget_create_pango_layout (GTK_WIDGET (digital), NULL);
+      pango_layout_set_alignment (digital->layout, PANGO_ALIGN_CENTER);
+    }
+  pango_layout_set_markup (digital->layout, digital->buffer->str, -1);
+
+  swap = digital->markup;
+  digital->markup = digital->buffer;
+  digital->buffer = swap;
+
+  /* the label only resizes if the template grew, all other
+   * ticks just redraw the layout */
+  xfce_clock_digital_update_template (digital);
+  gtk_widget_queue_draw (GTK_WIDGET (digital));
 
   return TRUE;
 }
@@ -41,6 +41,9 @@ static void     xfce_clock_fuzzy_get_property (GObject               *object,
                                                GValue                *value,
                                                GParamSpec            *pspec);
 static void     xfce_clock_fuzzy_finalize     (GObject               *object);
+static gboolean xfce_clock_fuzzy_draw         (GtkWidget             *widget,
+                                               cairo_t               *cr);
+static void     xfce_clock_fuzzy_style_updated (GtkWidget            *widget);
 static gboolean xfce_clock_fuzzy_update       (XfceClockFuzzy        *fuzzy,
                                                ClockTime             *time);
 
@@ -80,6 +83,11 @@ struct _XfceClockFuzzy
   guint               fuzziness;
 
   ClockTime          *time;
+
+  /* the text shown in the layout, the label holds the widest
+   * possible text for a stable size request */
+  GString            *text;
+  PangoLayout        *layout;
 };
 
 static const gchar *i18n_day_sectors[] =
@@ -157,13 +165,18 @@ XFCE_PANEL_DEFINE_TYPE (XfceClockFuzzy, xfce_clock_fuzzy, GTK_TYPE_LABEL)
 static void
 xfce_clock_fuzzy_class_init (XfceClockFuzzyClass *klass)
 {
-  GObjectClass *gobject_class;
+  GObjectClass   *gobject_class;
+  GtkWidgetClass *gtkwidget_class;
 
   gobject_class = G_OBJECT_CLASS (klass);
   gobject_class->set_property = xfce_clock_fuzzy_set_property;
   gobject_class->get_property = xfce_clock_fuzzy_get_property;
   gobject_class->finalize = xfce_clock_fuzzy_finalize;
 
+  gtkwidget_class = GTK_WIDGET_CLASS (klass);
+  gtkwidget_class->draw = xfce_clock_fuzzy_draw;
+  gtkwidget_class->style_updated = xfce_clock_fuzzy_style_updated;
+
   g_object_class_install_property (gobject_class,
                                    PROP_SIZE_RATIO,
                                    g_param_spec_double ("size-ratio", NULL, NULL,
@@ -191,10 +204,26 @@ xfce_clock_fuzzy_class_init (XfceClockFuzzyClass *klass)
 
 
 
+static void
+xfce_clock_fuzzy_reset (XfceClockFuzzy *fuzzy)
+{
+  /* measure the widest text again on the next update */
+  g_string_truncate (fuzzy->text, 0);
+
+  if (fuzzy->layout != NULL)
+    {
+      g_object_unref (G_OBJECT (fuzzy->layout));
+      fuzzy->layout = NULL;
+    }
+}
+
+
+
 static void
 xfce_clock_fuzzy_init (XfceClockFuzzy *fuzzy)
 {
   fuzzy->fuzziness = FUZZINESS_DEFAULT;
+  fuzzy->text = g_string_sized_new (64);
 
   gtk_label_set_justify (GTK_LABEL (fuzzy), GTK_JUSTIFY_CENTER);
 }
@@ -223,6 +252,7 @@ xfce_clock_fuzzy_set_property (GObject      *object,
       if (G_LIKELY (fuzzy->fuzziness != fuzziness))
         {
           fuzzy->fuzziness = fuzziness;
+          xfce_clock_fuzzy_reset (fuzzy);
           xfce_clock_fuzzy_update (fuzzy, fuzzy->time);
         }
       break;
@@ -264,37 +294,180 @@ xfce_clock_fuzzy_get_property (GObject    *object,
 static void
 xfce_clock_fuzzy_finalize (GObject *object)
 {
+  XfceClockFuzzy *fuzzy = XFCE_CLOCK_FUZZY (object);
+
   /* stop the timeout */
-  clock_time_timeout_free (XFCE_CLOCK_FUZZY (object)->timeout);
+  clock_time_timeout_free (fuzzy->timeout);
+
+  g_string_free (fuzzy->text, TRUE);
+  if (fuzzy->layout != NULL)
+    g_object_unref (G_OBJECT (fuzzy->layout));
 
   (*G_OBJECT_CLASS (xfce_clock_fuzzy_parent_class)->finalize) (object);
 }
 
 
 
+static gboolean
+xfce_clock_fuzzy_draw (GtkWidget *widget,
+                       cairo_t   *cr)
+{
+  XfceClockFuzzy *fuzzy = XFCE_CLOCK_FUZZY (widget);
+
+  if (G_UNLIKELY (fuzzy->layout == NULL))
+    return (*GTK_WIDGET_CLASS (xfce_clock_fuzzy_parent_class)->draw) (widget, cr);
+
+  return clock_plugin_label_draw (widget, fuzzy->layout, cr);
+}
+
+
+
+static void
+xfce_clock_fuzzy_style_updated (GtkWidget *widget)
+{
+  XfceClockFuzzy *fuzzy = XFCE_CLOCK_FUZZY (widget);
+
+  (*GTK_WIDGET_CLASS (xfce_clock_fuzzy_parent_class)->style_updated) (widget);
+
+  /* not constructed yet */
+  if (fuzzy->time == NULL)
+    return;
+
+  /* the font might have changed */
+  xfce_clock_fuzzy_reset (fuzzy);
+  xfce_clock_fuzzy_update (fuzzy, fuzzy->time);
+}
+
+
+
+static void
+xfce_clock_fuzzy_format (gint     sector,
+                         gint     hour,
+                         GString *string)
+{
+  const gchar *time_format;
+  const gchar *p;
+  gchar        pattern[3];
+
+  /* translated time string */
+  time_format = _(i18n_hour_sectors[sector]);
+
+  /* add hour offset (%0 or %1 on the string) */
+  p = strchr (time_format, '%');
+  panel_assert (p != NULL && g_ascii_isdigit (*(p + 1)));
+  if (G_LIKELY (p != NULL))
+    hour += g_ascii_digit_value (*(p + 1));
+
+  if (hour % 12 > 0)
+    hour = hour % 12 - 1;
+  else
+    hour = 12 - hour % 12 - 1;
+
+  if (hour == 0)
+    {
+      /* get the singular form of the format */
+      time_format = _(i18n_hour_sectors_one[sector]);
+
+      /* make sure we have to correct digit for the replace pattern */
+      p = strchr (time_format, '%');
+      panel_assert (p != NULL && g_ascii_isdigit (*(p + 1)));
+    }
+
+  /* replace the %? with the hour name */
+  g_snprintf (pattern, sizeof (pattern), "%%%c", p != NULL ? *(p + 1) : '0');
+  p = strstr (time_format, pattern);
+  if (p != NULL)
+    {
+      g_string_append_len (string, time_format, p - time_format);
+      g_string_append (string, _(i18n_hour_names[hour]));
+      g_string_append (string, p + strlen (pattern));
+    }
+  else
+    {
+      g_string_append (string, time_format);
+    }
+}
+
+
+
+static void
+xfce_clock_fuzzy_update_template (XfceClockFuzzy *fuzzy)
+{
+  PangoLayout *layout;
+  GString     *string, *widest;
+  gint         sector, hour;
+  gint         width, widest_width = -1;
+  guint        i;
+
+  layout = gtk_widget_create_pango_layout (GTK_WIDGET (fuzzy), NULL);
+  string = g_string_sized_new (64);
+  widest = g_string_sized_new (64);
+
+  /* measure all the texts this fuzziness can show once, so the
+   * label never has to resize on a tick */
+  if (fuzzy->fuzziness == FUZZINESS_DAY)
+    {
+      for (i = 0; i < G_N_ELEMENTS (i18n_day_sectors); i++)
+        {
+          g_string_assign (string, _(i18n_day_sectors[i]));
+          pango_layout_set_text (layout, string->str, string->len);
+          pango_layout_get_pixel_size (layout, &width, NULL);
+          if (width > widest_width)
+            {
+              widest_width = width;
+              g_string_assign (widest, string->str);
+            }
+        }
+    }
+  else
+    {
+      for (sector = 0; sector < (gint) G_N_ELEMENTS (i18n_hour_sectors);
+           sector += (fuzzy->fuzziness == FUZZINESS_5_MINS ? 1 : 3))
+        {
+          for (hour = 0; hour < 12; hour++)
+            {
+              g_string_truncate (string, 0);
+              xfce_clock_fuzzy_format (sector, hour, string);
+              pango_layout_set_text (layout, string->str, string->len);
+              pango_layout_get_pixel_size (layout, &width, NULL);
+              if (width > widest_width)
+                {
+                  widest_width = width;
+                  g_string_assign (widest, string->str);
+                }
+            }
+        }
+    }
+
+  gtk_label_set_text (GTK_LABEL (fuzzy), widest->str);
+
+  g_string_free (string, TRUE);
+  g_string_free (widest, TRUE);
+  g_object_unref (G_OBJECT (layout));
+}
+
+
+
 static gboolean
 xfce_clock_fuzzy_update (XfceClockFuzzy *fuzzy,
                          ClockTime      *time)
 {
   GDateTime      *date_time;
   gint            sector;
-  gint            minute, hour;
+  gint            minute;
   GString        *string;
-  const gchar    *time_format;
-  gchar          *p;
-  gchar           pattern[3];
 
   panel_return_val_if_fail (XFCE_CLOCK_IS_FUZZY (fuzzy), FALSE);
 
   /* get the local time */
   date_time = clock_time_get_time (fuzzy->time);
+  string = g_string_sized_new (64);
 
   if (fuzzy->fuzziness == FUZZINESS_5_MINS
       || fuzzy->fuzziness == FUZZINESS_15_MINS)
     {
       /* set the time */
       minute = g_date_time_get_minute (date_time);
-      hour = g_date_time_get_hour (date_time);
       sector = 0;
 
       /* get the hour sector */
@@ -309,61 +482,38 @@ xfce_clock_fuzzy_update (XfceClockFuzzy *fuzzy,
             sector = ((minute - 7) / 15 + 1) * 3;
         }
 
-      /* translated time string */
-      time_format = _(i18n_hour_sectors[sector]);
-
-      /* add hour offset (%0 or %1 on the string) */
-      p = strchr (time_format, '%');
-      panel_assert (p != NULL && g_ascii_isdigit (*(p + 1)));
-      if (G_LIKELY (p != NULL))
-        hour += g_ascii_digit_value (*(p + 1));
-
-      if (hour % 12 > 0)
-        hour = hour % 12 - 1;
-      else
-        hour = 12 - hour % 12 - 1;
+      xfce_clock_fuzzy_format (sector, g_date_time_get_hour (date_time), string);
+    }
+  else /* FUZZINESS_DAY */
+    {
+      g_string_append (string, _(i18n_day_sectors[g_date_time_get_hour (date_time) / 3]));
+    }
+  g_date_time_unref (date_time);
 
-      if (hour == 0)
+  /* only redraw if the text changed */
+  if (!g_string_equal (string, fuzzy->text))
+    {
+      if (fuzzy->layout == NULL)
         {
-          /* get the singular form of the format */
-          time_format = _(i18n_hour_sectors_one[sector]);
-
-          /* make sure we have to correct digit for the replace pattern */
-          p = strchr (time_format, '%');
-          panel_assert (p != NULL && g_ascii_isdigit (*(p + 1)));
-        }
-      
-      string = g_string_new (NULL);
+          /* size the label for the widest text of this fuzziness */
+          xfce_clock_fuzzy_update_template (fuzzy);
 
-      /* replace the %? with the hour name */
-      g_snprintf (pattern, sizeof (pattern), "%%%c", p != NULL ? *(p + 1) : '0');
-      p = strstr (time_format, pattern);
-      if (p != NULL)
-        {
-          g_string_append_len (string, time_format, p - time_format);
-          g_string_append (string, _(i18n_hour_names[hour]));
-          g_string_append (string, p + strlen (pattern));
-        }
-      else
-        {
-          g_string_append (string, time_format);
+          fuzzy->layout = gtk_widget_create_pango_layout (GTK_WIDGET (fuzzy), NULL);
+          pango_layout_set_alignment (fuzzy->layout, PANGO_ALIGN_CENTER);
         }
 
-      gtk_label_set_text (GTK_LABEL (fuzzy), string->str);
-      g_string_free (string, TRUE);
+      pango_layout_set_text (fuzzy->layout, string->str, string->len);
+      g_string_assign (fuzzy->text, string->str);
+      gtk_widget_queue_draw (GTK_WIDGET (fuzzy));
     }
-  else /* FUZZINESS_DAY */
-    {
-      gtk_label_set_text (GTK_LABEL (fuzzy), _(i18n_day_sectors[g_date_time_get_hour (date_time) / 3]));
-    }
-  g_date_time_unref (date_time);
+
+  g_string_free (string, TRUE);
 
   return TRUE;
 }
 
 
 
-
 GtkWidget *
 xfce_clock_fuzzy_new (ClockTime *time)
 {
@@ -17,6 +17,7 @@
  */
 
 
+#include <string.h>
 #include <glib.h>
 
 #include "clock-time.h"
@@ -36,6 +37,10 @@ static void                 clock_time_set_property   (GObject          *object,
 
 #define DEFAULT_TIMEZONE ""
 
+/* U+2007 FIGURE SPACE, glib pads %e, %k and %l with it because it is
+ * as wide as a digit */
+#define FIGURE_SPACE "\xe2\x80\x87"
+
 enum
 {
   PROP_0,
@@ -55,6 +60,40 @@ struct _ClockTime
   GTimeZone          *timezone;
 };
 
+typedef enum
+{
+  SEGMENT_TEXT,       /* static text */
+  SEGMENT_HOUR,       /* %H and %k */
+  SEGMENT_HOUR_12,    /* %I and %l */
+  SEGMENT_MINUTE,     /* %M */
+  SEGMENT_SECOND,     /* %S */
+  SEGMENT_DAY,        /* %d and %e */
+  SEGMENT_MONTH,      /* %m */
+  SEGMENT_YEAR,       /* %Y */
+  SEGMENT_YEAR_SHORT, /* %y */
+  SEGMENT_FORMAT      /* anything else, formatted by glib */
+}
+ClockTimeSegmentType;
+
+typedef struct
+{
+  ClockTimeSegmentType  type;
+
+  /* padding of single digit numbers, NULL for none */
+  const gchar          *padding;
+
+  /* static text or the format passed to glib */
+  gchar                *text;
+  gsize                 length;
+}
+ClockTimeSegment;
+
+struct _ClockTimeFormat
+{
+  ClockTimeSegment *segments;
+  guint             n_segments;
+};
+
 struct _ClockTimeTimeout
 {
   guint       interval;
@@ -259,6 +298,272 @@ clock_time_interval_from_format (const gchar *format)
 
 
 
+static void
+clock_time_format_add_text (GArray      *segments,
+                            const gchar *text,
+                            gsize        length)
+{
+  ClockTimeSegment *last;
+  ClockTimeSegment  segment = { SEGMENT_TEXT, 0, NULL, 0 };
+  gchar            *joined;
+
+  if (length == 0)
+    return;
+
+  /* merge with the previous text segment */
+  if (segments->len > 0)
+    {
+      last = &g_array_index (segments, ClockTimeSegment, segments->len - 1);
+      if (last->type == SEGMENT_TEXT)
+        {
+          joined = g_malloc (last->length + length + 1);
+          memcpy (joined, last->text, last->length);
+          memcpy (joined + last->length, text, length);
+          joined[last->length + length] = '\0';
+
+          g_free (last->text);
+          last->text = joined;
+          last->length += length;
+          return;
+        }
+    }
+
+  segment.text = g_strndup (text, length);
+  segment.length = length;
+  g_array_append_val (segments, segment);
+}
+
+
+
+ClockTimeFormat *
+clock_time_format_new (const gchar *format)
+{
+  ClockTimeFormat  *compiled;
+  GArray           *segments;
+  ClockTimeSegment  segment;
+  const gchar      *p, *text;
+
+  segments = g_array_new (FALSE, FALSE, sizeof (ClockTimeSegment));
+
+  for (p = text = (format != NULL ? format : ""); *p != '\0'; p++)
+    {
+      if (p[0] != '%' || p[1] == '\0')
+        continue;
+
+      clock_time_format_add_text (segments, text, p - text);
+
+      segment.padding = "0";
+      segment.text = NULL;
+      segment.length = 0;
+
+      switch (p[1])
+        {
+        case '%':
+          clock_time_format_add_text (segments, "%", 1);
+          p++;
+          text = p + 1;
+          continue;
+
+        case 'k':
+          segment.padding = FIGURE_SPACE;
+          /* fall through */
+        case 'H':
+          segment.type = SEGMENT_HOUR;
+          break;
+
+        case 'l':
+          segment.padding = FIGURE_SPACE;
+          /* fall through */
+        case 'I':
+          segment.type = SEGMENT_HOUR_12;
+          break;
+
+        case 'M':
+          segment.type = SEGMENT_MINUTE;
+          break;
+
+        case 'S':
+          segment.type = SEGMENT_SECOND;
+          break;
+
+        case 'e':
+          segment.padding = FIGURE_SPACE;
+          /* fall through */
+        case 'd':
+          segment.type = SEGMENT_DAY;
+          break;
+
+        case 'm':
+          segment.type = SEGMENT_MONTH;
+          break;
+
+        case 'Y':
+          segment.type = SEGMENT_YEAR;
+          segment.padding = NULL;
+          break;
+
+        case 'y':
+          segment.type = SEGMENT_YEAR_SHORT;
+          break;
+
+        default:
+          /* locale dependent conversions and modifiers, pass the
+           * conversion including its modifiers to glib */
+          segment.type = SEGMENT_FORMAT;
+          text = p++;
+          while (*p != '\0' && strchr ("-_0EO:", *p) != NULL)
+            p++;
+          if (*p == '\0')
+            p--;
+          segment.text = g_strndup (text, p - text + 1);
+          segment.length = p - text + 1;
+          g_array_append_val (segments, segment);
+          text = p + 1;
+          continue;
+        }
+
+      g_array_append_val (segments, segment);
+
+      p++;
+      text = p + 1;
+    }
+
+  clock_time_format_add_text (segments, text, p - text);
+
+  compiled = g_slice_new (ClockTimeFormat);
+  compiled->n_segments = segments->len;
+  compiled->segments = (ClockTimeSegment *) g_array_free (segments, FALSE);
+
+  return compiled;
+}
+
+
+
+static inline void
+clock_time_format_append_number (GString     *string,
+                                 gint         number,
+                                 const gchar *padding)
+{
+  if (number < 10)
+    {
+      if (padding != NULL)
+        g_string_append (string, padding);
+      g_string_append_c (string, '0' + number);
+    }
+  else if (number < 100)
+    {
+      g_string_append_c (string, '0' + number / 10);
+      g_string_append_c (string, '0' + number % 10);
+    }
+  else
+    {
+      g_string_append_printf (string, "%d", number);
+    }
+}
+
+
+
+void
+clock_time_format_render (ClockTimeFormat *format,
+                          ClockTime       *time,
+                          GString         *string)
+{
+  GDateTime        *date_time;
+  ClockTimeSegment *segment;
+  guint             i;
+  gint              hour;
+  gchar            *str;
+
+  panel_return_if_fail (format != NULL);
+  panel_return_if_fail (XFCE_IS_CLOCK_TIME (time));
+  panel_return_if_fail (string != NULL);
+
+  g_string_truncate (string, 0);
+
+  date_time = clock_time_get_time (time);
+
+  for (i = 0; i < format->n_segments; i++)
+    {
+      segment = &format->segments[i];
+
+      switch (segment->type)
+        {
+        case SEGMENT_TEXT:
+          g_string_append_len (string, segment->text, segment->length);
+          break;
+
+        case SEGMENT_HOUR:
+          clock_time_format_append_number (string, g_date_time_get_hour (date_time),
+                                           segment->padding);
+          break;
+
+        case SEGMENT_HOUR_12:
+          hour = g_date_time_get_hour (date_time) % 12;
+          clock_time_format_append_number (string, hour == 0 ? 12 : hour,
+                                           segment->padding);
+          break;
+
+        case SEGMENT_MINUTE:
+          clock_time_format_append_number (string, g_date_time_get_minute (date_time),
+                                           segment->padding);
+          break;
+
+        case SEGMENT_SECOND:
+          clock_time_format_append_number (string, g_date_time_get_second (date_time),
+                                           segment->padding);
+          break;
+
+        case SEGMENT_DAY:
+          clock_time_format_append_number (string, g_date_time_get_day_of_month (date_time),
+                                           segment->padding);
+          break;
+
+        case SEGMENT_MONTH:
+          clock_time_format_append_number (string, g_date_time_get_month (date_time),
+                                           segment->padding);
+          break;
+
+        case SEGMENT_YEAR:
+          clock_time_format_append_number (string, g_date_time_get_year (date_time),
+                                           segment->padding);
+          break;
+
+        case SEGMENT_YEAR_SHORT:
+          clock_time_format_append_number (string, g_date_time_get_year (date_time) % 100,
+                                           segment->padding);
+          break;
+
+        case SEGMENT_FORMAT:
+          str = g_date_time_format (date_time, segment->text);
+          if (G_LIKELY (str != NULL))
+            g_string_append (string, str);
+          g_free (str);
+          break;
+        }
+    }
+
+  g_date_time_unref (date_time);
+}
+
+
+
+void
+clock_time_format_free (ClockTimeFormat *format)
+{
+  guint i;
+
+  if (format == NULL)
+    return;
+
+  for (i = 0; i < format->n_segments; i++)
+    g_free (format->segments[i].text);
+  g_free (format->segments);
+
+  g_slice_free (ClockTimeFormat, format);
+}
+
+
+
 static gboolean
 clock_time_timeout_running (gpointer user_data)
 {
@@ -31,6 +31,7 @@ G_BEGIN_DECLS
 typedef struct _ClockTime          ClockTime;
 typedef struct _ClockTimeClass     ClockTimeClass;
 typedef struct _ClockTimeTimeout   ClockTimeTimeout;
+typedef struct _ClockTimeFormat    ClockTimeFormat;
 
 #define XFCE_TYPE_CLOCK_TIME              (clock_time_get_type ())
 #define XFCE_CLOCK_TIME(obj)              (G_TYPE_CHECK_INSTANCE_CAST ((obj), XFCE_TYPE_CLOCK_TIME, ClockTime))
@@ -64,6 +65,14 @@ gchar              *clock_time_strdup_strftime        (ClockTime           *time
 
 guint               clock_time_interval_from_format   (const gchar         *format);
 
+ClockTimeFormat    *clock_time_format_new             (const gchar         *format);
+
+void                clock_time_format_render          (ClockTimeFormat     *format,
+                                                       ClockTime           *time,
+                                                       GString             *string);
+
+void                clock_time_format_free            (ClockTimeFormat     *format);
+
 G_END_DECLS
 
 #endif /* !__CLOCK_TIME_H__ */
@@ -1367,3 +1367,67 @@ clock_plugin_tooltip (gpointer user_data)
   /* keep the timeout running */
   return TRUE;
 }
+
+
+
+gint
+clock_plugin_label_measure (GtkWidget   *label,
+                            const gchar *markup)
+{
+  PangoLayout *layout;
+  gint         width;
+
+  panel_return_val_if_fail (GTK_IS_LABEL (label), 0);
+
+  /* logical width of the markup in the font of the label */
+  layout = gtk_widget_create_pango_layout (label, NULL);
+  pango_layout_set_markup (layout, markup, -1);
+  pango_layout_get_pixel_size (layout, &width, NULL);
+  g_object_unref (G_OBJECT (layout));
+
+  return width;
+}
+
+
+
+gboolean
+clock_plugin_label_draw (GtkWidget   *label,
+                         PangoLayout *layout,
+                         cairo_t     *cr)
+{
+  GtkStyleContext *context;
+  PangoRectangle   logical;
+  gint             width, height;
+  gdouble          angle;
+
+  panel_return_val_if_fail (GTK_IS_LABEL (label), FALSE);
+  panel_return_val_if_fail (PANGO_IS_LAYOUT (layout), FALSE);
+
+  /* the label text is only used for the size request, draw the
+   * current time layout centered in the allocation instead */
+  context = gtk_widget_get_style_context (label);
+  width = gtk_widget_get_allocated_width (label);
+  height = gtk_widget_get_allocated_height (label);
+
+  gtk_render_background (context, cr, 0, 0, width, height);
+  gtk_render_frame (context, cr, 0, 0, width, height);
+
+  cairo_save (cr);
+  cairo_translate (cr, width / 2.0, height / 2.0);
+
+  /* the label angle is counter-clockwise */
+  angle = gtk_label_get_angle (GTK_LABEL (label));
+  if (angle != 0.0)
+    cairo_rotate (cr, -angle * G_PI / 180.0);
+  pango_cairo_update_layout (cr, layout);
+
+  pango_layout_get_pixel_extents (layout, NULL, &logical);
+  gtk_render_layout (context, cr,
+                     -logical.x - logical.width / 2.0,
+                     -logical.y - logical.height / 2.0,
+                     layout);
+
+  cairo_restore (cr);
+
+  return FALSE;
+}
@@ -46,6 +46,13 @@ GType               clock_plugin_get_type             (void) G_GNUC_CONST;
 
 void                clock_plugin_register_type        (XfcePanelTypeModule *type_module);
 
+gint                clock_plugin_label_measure        (GtkWidget           *label,
+                                                       const gchar         *markup);
+
+gboolean            clock_plugin_label_draw           (GtkWidget           *label,
+                                                       PangoLayout         *layout,
+                                                       cairo_t             *cr);
+
 G_END_DECLS
 
 #endif /* !__CLOCK_H__ */
@@ -0,0 +1,450 @@
+/*
+ * Copyright (C) 2008-2010 Nick Schermer <nick@xfce.org>
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gtk/gtk.h>
+#include <libxfce4util/libxfce4util.h>
+#include <garcon/garcon.h>
+
+#include <common/panel-private.h>
+
+#include "launcher-cache.h"
+
+/* maximum number of threads parsing desktop files during startup,
+ * the work is mostly waiting on the disk so don't go crazy here */
+#define CACHE_MAX_THREADS (4)
+
+
+
+typedef struct _LauncherCacheEntry LauncherCacheEntry;
+
+
+
+static guint64 launcher_cache_file_mtime         (GFile        *file);
+static void    launcher_cache_entry_free         (gpointer      data);
+static void    launcher_cache_load_func          (gpointer      data,
+                                                  gpointer      user_data);
+static void    launcher_cache_icon_theme_changed (GtkIconTheme *icon_theme,
+                                                  gpointer      user_data);
+
+
+
+struct _LauncherCacheEntry
+{
+  /* the desktop file, also the key in the hash table */
+  GFile          *file;
+
+  /* modification time of the file when the item was loaded */
+  guint64         mtime;
+
+  /* the loaded item, NULL while loading or if loading failed */
+  GarconMenuItem *item;
+
+  /* whether a worker thread is still parsing the file */
+  guint           loading : 1;
+
+  /* drop the entry once the worker thread is done */
+  guint           removed : 1;
+};
+
+
+
+/* one table for all launchers in this process, so their files are
+ * parsed in parallel during startup; each launcher only reads the
+ * files in its own directory, so items are never shared. the lock
+ * protects the table and the entries, the main thread never waits
+ * for a worker thread */
+static GMutex       cache_lock;
+static GHashTable  *cache_table = NULL;
+static GThreadPool *cache_pool = NULL;
+
+/* pre-scaled icons, keyed by "<size>@<scale>:<icon-name>", only
+ * used from the main thread so no locking needed */
+static GHashTable  *cache_icons = NULL;
+
+
+
+static guint64
+launcher_cache_file_mtime (GFile *file)
+{
+  GFileInfo *info;
+  guint64    mtime = 0;
+
+  info = g_file_query_info (file,
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+                            G_FILE_QUERY_INFO_NONE, NULL, NULL);
+  if (G_LIKELY (info != NULL))
+    {
+      mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC
+              + g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+      g_object_unref (G_OBJECT (info));
+    }
+
+  return mtime;
+}
+
+
+
+static void
+launcher_cache_entry_free (gpointer data)
+{
+  LauncherCacheEntry *entry = data;
+
+  panel_assert (!entry->loading);
+
+  if (entry->item != NULL)
+    g_object_unref (G_OBJECT (entry->item));
+  g_object_unref (G_OBJECT (entry->file));
+  g_slice_free (LauncherCacheEntry, entry);
+}
+
+
+
+static void
+launcher_cache_load_func (gpointer data,
+                          gpointer user_data)
+{
+  LauncherCacheEntry *entry = data;
+  GarconMenuItem     *item;
+  guint64             mtime;
+
+  /* the entry file is never touched by the main thread while
+   * loading is set, so it's safe to use it without the lock */
+  mtime = launcher_cache_file_mtime (entry->file);
+  item = garcon_menu_item_new (entry->file);
+
+  g_mutex_lock (&cache_lock);
+
+  entry->item = item;
+  entry->mtime = mtime;
+  entry->loading = FALSE;
+
+  /* the file was removed while it was loading */
+  if (G_UNLIKELY (entry->removed))
+    g_hash_table_remove (cache_table, entry->file);
+
+  g_mutex_unlock (&cache_lock);
+}
+
+
+
+static void
+launcher_cache_ensure_table (void)
+{
+  if (G_UNLIKELY (cache_table == NULL))
+    cache_table = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal,
+                                         NULL, launcher_cache_entry_free);
+}
+
+
+
+/**
+ * launcher_cache_prefetch:
+ * @plugin_name : name of the launcher plugin.
+ *
+ * Queue all the desktop files in the configuration directories of
+ * all launchers for loading in worker threads. This only does
+ * something on the first call, so each launcher can call this during
+ * construction and items requested with launcher_cache_get_item()
+ * are likely already loaded by the time the launcher asks for them.
+ **/
+void
+launcher_cache_prefetch (const gchar *plugin_name)
+{
+  static gboolean     prefetched = FALSE;
+  gchar              *path, *prefix, *dir_path, *file_path;
+  GDir               *dir, *launcher_dir;
+  const gchar        *name, *filename;
+  GFile              *file;
+  LauncherCacheEntry *entry;
+
+  panel_return_if_fail (plugin_name != NULL);
+
+  if (prefetched)
+    return;
+  prefetched = TRUE;
+
+  path = xfce_resource_save_location (XFCE_RESOURCE_CONFIG,
+                                      PANEL_PLUGIN_RELATIVE_PATH, FALSE);
+  dir = path != NULL ? g_dir_open (path, 0, NULL) : NULL;
+  if (G_UNLIKELY (dir == NULL))
+    {
+      g_free (path);
+      return;
+    }
+
+  if (G_LIKELY (cache_pool == NULL))
+    cache_pool = g_thread_pool_new (launcher_cache_load_func, NULL,
+                                    CACHE_MAX_THREADS, FALSE, NULL);
+
+  g_mutex_lock (&cache_lock);
+  launcher_cache_ensure_table ();
+
+  /* walk all the launcher-<id> directories */
+  prefix = g_strconcat (plugin_name, "-", NULL);
+  while ((name = g_dir_read_name (dir)) != NULL)
+    {
+      if (!g_str_has_prefix (name, prefix))
+        continue;
+
+      dir_path = g_build_filename (path, name, NULL);
+      launcher_dir = g_dir_open (dir_path, 0, NULL);
+      if (G_LIKELY (launcher_dir != NULL))
+        {
+          while ((filename = g_dir_read_name (launcher_dir)) != NULL)
+            {
+              if (!g_str_has_suffix (filename, ".desktop"))
+                continue;
+
+              file_path = g_build_filename (dir_path, filename, NULL);
+              file = g_file_new_for_path (file_path);
+              g_free (file_path);
+
+              if (g_hash_table_lookup (cache_table, file) != NULL)
+                {
+                  g_object_unref (G_OBJECT (file));
+                  continue;
+                }
+
+              entry = g_slice_new0 (LauncherCacheEntry);
+              entry->file = file;
+              entry->loading = TRUE;
+              g_hash_table_insert (cache_table, entry->file, entry);
+
+              g_thread_pool_push (cache_pool, entry, NULL);
+            }
+
+          g_dir_close (launcher_dir);
+        }
+
+      g_free (dir_path);
+    }
+
+  g_mutex_unlock (&cache_lock);
+
+  g_free (prefix);
+  g_dir_close (dir);
+  g_free (path);
+}
+
+
+
+/**
+ * launcher_cache_get_item:
+ * @file : a desktop file.
+ *
+ * Lookup the menu item for @file in the cache, if the file was not
+ * loaded yet or has changed on disk since it was loaded, the item is
+ * (re)loaded. If a worker thread is still busy loading the file, the
+ * file is parsed here instead of waiting for the thread.
+ *
+ * Returns: a new reference to the #GarconMenuItem or %NULL if the file
+ *          could not be loaded.
+ **/
+GarconMenuItem *
+launcher_cache_get_item (GFile *file)
+{
+  LauncherCacheEntry *entry;
+  GarconMenuItem     *item = NULL;
+  guint64             mtime;
+
+  panel_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  /* without modification time we cannot validate the cache */
+  mtime = launcher_cache_file_mtime (file);
+  if (G_UNLIKELY (mtime == 0))
+    return garcon_menu_item_new (file);
+
+  g_mutex_lock (&cache_lock);
+  launcher_cache_ensure_table ();
+
+  entry = g_hash_table_lookup (cache_table, file);
+  if (entry != NULL
+      && !entry->loading
+      && entry->item != NULL
+      && entry->mtime == mtime)
+    item = g_object_ref (G_OBJECT (entry->item));
+
+  g_mutex_unlock (&cache_lock);
+
+  if (item != NULL)
+    return item;
+
+  /* load the file outside the lock, also when a worker thread is
+   * still busy with it, parsing a single file is cheaper than
+   * waiting for the threads in the main loop */
+  item = garcon_menu_item_new (file);
+  if (G_UNLIKELY (item == NULL))
+    return NULL;
+
+  g_mutex_lock (&cache_lock);
+
+  /* lookup again, the entry was not locked during loading */
+  entry = g_hash_table_lookup (cache_table, file);
+  if (entry != NULL && entry->loading)
+    {
+      /* the worker thread owns the entry until it is done */
+      g_mutex_unlock (&cache_lock);
+      return item;
+    }
+  else if (entry == NULL)
+    {
+      entry = g_slice_new0 (LauncherCacheEntry);
+      entry->file = g_object_ref (G_OBJECT (file));
+      g_hash_table_insert (cache_table, entry->file, entry);
+    }
+  else if (entry->item != NULL)
+    {
+      /* release the outdated item, launchers still using it will
+       * receive a reload from their file monitor */
+      g_object_unref (G_OBJECT (entry->item));
+    }
+
+  entry->item = g_object_ref (G_OBJECT (item));
+  entry->mtime = mtime;
+
+  g_mutex_unlock (&cache_lock);
+
+  return item;
+}
+
+
+
+/**
+ * launcher_cache_remove_item:
+ * @file : a desktop file.
+ *
+ * Drop @file from the cache, used when a desktop file is deleted.
+ **/
+void
+launcher_cache_remove_item (GFile *file)
+{
+  LauncherCacheEntry *entry;
+
+  panel_return_if_fail (G_IS_FILE (file));
+
+  g_mutex_lock (&cache_lock);
+
+  if (G_LIKELY (cache_table != NULL))
+    {
+      entry = g_hash_table_lookup (cache_table, file);
+      if (entry != NULL)
+        {
+          /* let the worker thread drop the entry when it is done */
+          if (entry->loading)
+            entry->removed = TRUE;
+          else
+            g_hash_table_remove (cache_table, file);
+        }
+    }
+
+  g_mutex_unlock (&cache_lock);
+}
+
+
+
+/**
+ * launcher_cache_get_icon:
+ * @screen    : a #GdkScreen or %NULL for the default icon theme.
+ * @icon_name : an icon name or an absolute path to an image.
+ * @size      : the size of the icon in logical pixels.
+ * @scale     : the scale factor of the widget showing the icon.
+ *
+ * Return a pixbuf of @icon_name scaled to @size * @scale pixels. The
+ * pixbuf is loaded once and shared by all launchers, so showing
+ * tooltips and menus does not hit the disk. The cache is flushed
+ * when the default icon theme changes.
+ *
+ * Returns: a new reference to the pixbuf or %NULL if the icon could
+ *          not be loaded.
+ **/
+GdkPixbuf *
+launcher_cache_get_icon (GdkScreen   *screen,
+                         const gchar *icon_name,
+                         gint         size,
+                         gint         scale)
+{
+  GtkIconTheme *theme;
+  GdkPixbuf    *pixbuf;
+  gchar        *key;
+
+  panel_return_val_if_fail (screen == NULL || GDK_IS_SCREEN (screen), NULL);
+  panel_return_val_if_fail (size > 0 && scale > 0, NULL);
+
+  if (panel_str_is_empty (icon_name))
+    return NULL;
+
+  if (G_UNLIKELY (cache_icons == NULL))
+    {
+      cache_icons = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           g_free, g_object_unref);
+
+      /* flush the icons once for all launchers, the module is
+       * resident so the handler is never disconnected */
+      g_signal_connect (G_OBJECT (gtk_icon_theme_get_default ()), "changed",
+          G_CALLBACK (launcher_cache_icon_theme_changed), NULL);
+    }
+
+  key = g_strdup_printf ("%d@%d:%s", size, scale, icon_name);
+  pixbuf = g_hash_table_lookup (cache_icons, key);
+  if (pixbuf != NULL)
+    {
+      g_free (key);
+      return g_object_ref (G_OBJECT (pixbuf));
+    }
+
+  if (G_UNLIKELY (g_path_is_absolute (icon_name)))
+    {
+      /* load directly from a file */
+      pixbuf = gdk_pixbuf_new_from_file_at_scale (icon_name, size * scale,
+                                                  size * scale, TRUE, NULL);
+    }
+  else
+    {
+      if (G_LIKELY (screen != NULL))
+        theme = gtk_icon_theme_get_for_screen (screen);
+      else
+        theme = gtk_icon_theme_get_default ();
+
+      pixbuf = gtk_icon_theme_load_icon_for_scale (theme, icon_name, size, scale,
+                                                   GTK_ICON_LOOKUP_FORCE_SIZE, NULL);
+    }
+
+  /* failures are not cached, the icon might show up in the theme later */
+  if (G_LIKELY (pixbuf != NULL))
+    g_hash_table_insert (cache_icons, key, g_object_ref (G_OBJECT (pixbuf)));
+  else
+    g_free (key);
+
+  return pixbuf;
+}
+
+
+
+static void
+launcher_cache_icon_theme_changed (GtkIconTheme *icon_theme,
+                                   gpointer      user_data)
+{
+  /* release all the icons in the cache */
+  if (cache_icons != NULL)
+    g_hash_table_remove_all (cache_icons);
+}
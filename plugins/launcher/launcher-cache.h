@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2008-2010 Nick Schermer <nick@xfce.org>
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __LAUNCHER_CACHE_H__
+#define __LAUNCHER_CACHE_H__
+
+#include <gtk/gtk.h>
+#include <garcon/garcon.h>
+
+G_BEGIN_DECLS
+
+void            launcher_cache_prefetch    (const gchar *plugin_name);
+
+GarconMenuItem *launcher_cache_get_item    (GFile       *file);
+
+void            launcher_cache_remove_item (GFile       *file);
+
+GdkPixbuf      *launcher_cache_get_icon    (GdkScreen   *screen,
+                                            const gchar *icon_name,
+                                            gint         size,
+                                            gint         scale);
+
+G_END_DECLS
+
+#endif /* !__LAUNCHER_CACHE_H__ */
@@ -36,10 +36,12 @@
 #include <common/panel-utils.h>
 
 #include "launcher.h"
+#include "launcher-cache.h"
 #include "launcher-dialog.h"
 
 #define ARROW_BUTTON_SIZE              (12)
 #define MENU_POPUP_DELAY               (225)
+#define CONFIG_CHANGES_DELAY           (250)
 #define NO_ARROW_INSIDE_BUTTON(plugin) ((plugin)->arrow_position != LAUNCHER_ARROW_INTERNAL \
                                         || LIST_HAS_ONE_OR_NO_ENTRIES ((plugin)->items))
 #define ARROW_INSIDE_BUTTON(plugin)    (!NO_ARROW_INSIDE_BUTTON (plugin))
@@ -72,6 +74,9 @@ static void               launcher_plugin_screen_position_changed       (XfcePan
                                                                          XfceScreenPosition    position);
 static void               launcher_plugin_icon_theme_changed            (GtkIconTheme         *icon_theme,
                                                                          LauncherPlugin       *plugin);
+static void               launcher_plugin_scale_factor_changed          (GObject              *object,
+                                                                         GParamSpec           *pspec,
+                                                                         LauncherPlugin       *plugin);
 static LauncherArrowType  launcher_plugin_default_arrow_type            (LauncherPlugin       *plugin);
 static void               launcher_plugin_pack_widgets                  (LauncherPlugin       *plugin);
 static GdkPixbuf         *launcher_plugin_tooltip_pixbuf                (GdkScreen            *screen,
@@ -174,6 +179,7 @@ static gboolean           launcher_plugin_exec_parse                    (GarconM
                                                                          GError              **error);
 static GSList            *launcher_plugin_uri_list_extract              (GtkSelectionData     *data);
 static void               launcher_plugin_uri_list_free                 (GSList               *uri_list);
+static GHashTable        *launcher_plugin_garcon_menu_pool_shared       (void);
 
 
 
@@ -194,8 +200,6 @@ struct _LauncherPlugin
 
   GSList            *items;
 
-  GdkPixbuf         *tooltip_cache;
-
   gulong             theme_change_id;
 
   guint              menu_timeout_id;
@@ -208,6 +212,11 @@ struct _LauncherPlugin
   GFile             *config_directory;
   GFileMonitor      *config_monitor;
 
+  /* desktop files changed in the config directory, processed
+   * together in a timeout to avoid a reload for each event */
+  GHashTable        *config_changes;
+  guint              config_changes_timeout_id;
+
   guint              save_timeout_id;
 };
 
@@ -237,6 +246,9 @@ XFCE_PANEL_DEFINE_PLUGIN_RESIDENT (LauncherPlugin, launcher_plugin)
 static GQuark      launcher_plugin_quark = 0;
 static guint       launcher_signals[LAST_SIGNAL];
 
+/* application pool shared by all launchers during startup */
+static GHashTable *launcher_plugin_shared_pool = NULL;
+
 
 
 /* target types for dropping in the launcher plugin */
@@ -333,15 +345,20 @@ launcher_plugin_init (LauncherPlugin *plugin)
   plugin->menu = NULL;
   plugin->items = NULL;
   plugin->child = NULL;
-  plugin->tooltip_cache = NULL;
   plugin->menu_timeout_id = 0;
   plugin->save_timeout_id = 0;
+  plugin->config_changes = NULL;
+  plugin->config_changes_timeout_id = 0;
 
   /* monitor the default icon theme for changes */
   icon_theme = gtk_icon_theme_get_default ();
   plugin->theme_change_id = g_signal_connect (G_OBJECT (icon_theme), "changed",
       G_CALLBACK (launcher_plugin_icon_theme_changed), plugin);
 
+  /* the menu icons are rendered for the scale factor */
+  g_signal_connect (G_OBJECT (plugin), "notify::scale-factor",
+      G_CALLBACK (launcher_plugin_scale_factor_changed), plugin);
+
   /* create the panel widgets */
   plugin->box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
   gtk_container_add (GTK_CONTAINER (plugin), plugin->box);
@@ -645,13 +662,18 @@ launcher_plugin_item_load (LauncherPlugin *plugin,
         {
           item = GARCON_MENU_ITEM (li->data);
           plugin->items = g_slist_delete_link (plugin->items, li);
+
+          /* the caller connects the changed signal again */
+          g_signal_handlers_disconnect_by_func (G_OBJECT (item),
+              G_CALLBACK (launcher_plugin_item_changed), plugin);
         }
       g_object_unref (G_OBJECT (dst_file));
     }
 
-  /* load the file from the disk */
+  /* get the file from the cache shared by all launchers, this only
+   * hits the disk if the file was not loaded before or changed */
   if (item == NULL)
-    item = garcon_menu_item_new (src_file);
+    item = launcher_cache_get_item (src_file);
 
   g_object_unref (G_OBJECT (src_file));
 
@@ -675,7 +697,11 @@ launcher_plugin_items_delete_configs (LauncherPlugin *plugin)
     {
       file = garcon_menu_item_get_file (li->data);
       if (g_file_has_prefix (file, plugin->config_directory))
-        succeed = g_file_delete (file, NULL, &error);
+        {
+          succeed = g_file_delete (file, NULL, &error);
+          if (succeed)
+            launcher_cache_remove_item (file);
+        }
       g_object_unref (G_OBJECT (file));
     }
 
@@ -693,9 +719,19 @@ launcher_plugin_items_delete_configs (LauncherPlugin *plugin)
 static void
 launcher_plugin_items_free (LauncherPlugin *plugin)
 {
+  GSList *li;
+
   if (G_LIKELY (plugin->items != NULL))
     {
-      g_slist_foreach (plugin->items, (GFunc) g_object_unref, NULL);
+      /* items are shared with other launchers through the cache, so
+       * make sure we don't receive their changes anymore */
+      for (li = plugin->items; li != NULL; li = li->next)
+        {
+          g_signal_handlers_disconnect_by_func (G_OBJECT (li->data),
+              G_CALLBACK (launcher_plugin_item_changed), plugin);
+          g_object_unref (G_OBJECT (li->data));
+        }
+
       g_slist_free (plugin->items);
       plugin->items = NULL;
     }
@@ -750,7 +786,7 @@ launcher_plugin_items_load (LauncherPlugin *plugin,
 
           /* load the pool with desktop items */
           if (pool == NULL)
-            pool = launcher_plugin_garcon_menu_pool ();
+            pool = launcher_plugin_garcon_menu_pool_shared ();
 
           /* lookup the item in the item pool */
           pool_item = g_hash_table_lookup (pool, str);
@@ -784,7 +820,7 @@ launcher_plugin_items_load (LauncherPlugin *plugin,
     }
 
   if (G_UNLIKELY (pool != NULL))
-    g_hash_table_destroy (pool);
+    g_hash_table_unref (pool);
 
   /* remove config files of items not in the new config */
   launcher_plugin_items_delete_configs (plugin);
@@ -894,39 +930,18 @@ update_arrow:
 
 
 
-static void
-launcher_plugin_file_changed (GFileMonitor      *monitor,
-                              GFile             *changed_file,
-                              GFile             *other_file,
-                              GFileMonitorEvent  event_type,
-                              LauncherPlugin    *plugin)
+static gboolean
+launcher_plugin_file_changes_apply (LauncherPlugin *plugin,
+                                    GFile          *changed_file)
 {
   GSList         *li, *lnext;
   GarconMenuItem *item;
   GFile          *item_file;
   gboolean        found;
   GError         *error = NULL;
-  gchar          *base_name;
-  gboolean        result;
   gboolean        exists;
   gboolean        update_plugin = FALSE;
 
-  panel_return_if_fail (XFCE_IS_LAUNCHER_PLUGIN (plugin));
-  panel_return_if_fail (plugin->config_monitor == monitor);
-
-  /* waited until all events are proccessed */
-  if (event_type != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT
-      && event_type != G_FILE_MONITOR_EVENT_DELETED
-      && event_type != G_FILE_MONITOR_EVENT_CREATED)
-    return;
-
-  /* we only act on desktop files */
-  base_name = g_file_get_basename (changed_file);
-  result = g_str_has_suffix (base_name, ".desktop");
-  g_free (base_name);
-  if (!result)
-    return;
-
   exists = g_file_query_exists (changed_file, NULL);
 
   /* lookup the file in the menu items */
@@ -951,7 +966,10 @@ launcher_plugin_file_changed (GFileMonitor      *monitor,
             {
               /* remove from the list */
               plugin->items = g_slist_delete_link (plugin->items, li);
+              g_signal_handlers_disconnect_by_func (G_OBJECT (item),
+                  G_CALLBACK (launcher_plugin_item_changed), plugin);
               g_object_unref (G_OBJECT (item));
+              launcher_cache_remove_item (changed_file);
               update_plugin = TRUE;
             }
         }
@@ -961,7 +979,7 @@ launcher_plugin_file_changed (GFileMonitor      *monitor,
   if (!found && exists)
     {
       /* add the new file to the config */
-      item = garcon_menu_item_new (changed_file);
+      item = launcher_cache_get_item (changed_file);
       if (G_LIKELY (item != NULL))
         {
           plugin->items = g_slist_append (plugin->items, item);
@@ -971,6 +989,34 @@ launcher_plugin_file_changed (GFileMonitor      *monitor,
         }
     }
 
+  return update_plugin;
+}
+
+
+
+static gboolean
+launcher_plugin_file_changes_timeout (gpointer user_data)
+{
+  LauncherPlugin *plugin = XFCE_LAUNCHER_PLUGIN (user_data);
+  GHashTable     *changes;
+  GHashTableIter  iter;
+  gpointer        changed_file;
+  gboolean        update_plugin = FALSE;
+
+  panel_return_val_if_fail (plugin->config_changes != NULL, FALSE);
+
+  /* take the pending changes, so new events start a new batch */
+  changes = plugin->config_changes;
+  plugin->config_changes = NULL;
+
+  g_hash_table_iter_init (&iter, changes);
+  while (g_hash_table_iter_next (&iter, &changed_file, NULL))
+    if (launcher_plugin_file_changes_apply (plugin, G_FILE (changed_file)))
+      update_plugin = TRUE;
+
+  g_hash_table_destroy (changes);
+
+  /* update everything once for the whole batch */
   if (update_plugin)
     {
       launcher_plugin_button_update (plugin);
@@ -982,6 +1028,75 @@ launcher_plugin_file_changed (GFileMonitor      *monitor,
       /* update the dialog */
       g_signal_emit (G_OBJECT (plugin), launcher_signals[ITEMS_CHANGED], 0);
     }
+
+  return FALSE;
+}
+
+
+
+static void
+launcher_plugin_file_changes_timeout_destroyed (gpointer user_data)
+{
+  XFCE_LAUNCHER_PLUGIN (user_data)->config_changes_timeout_id = 0;
+}
+
+
+
+static void
+launcher_plugin_file_changes_cancel (LauncherPlugin *plugin)
+{
+  if (plugin->config_changes_timeout_id != 0)
+    g_source_remove (plugin->config_changes_timeout_id);
+
+  if (plugin->config_changes != NULL)
+    {
+      g_hash_table_destroy (plugin->config_changes);
+      plugin->config_changes = NULL;
+    }
+}
+
+
+
+static void
+launcher_plugin_file_changed (GFileMonitor      *monitor,
+                              GFile             *changed_file,
+                              GFile             *other_file,
+                              GFileMonitorEvent  event_type,
+                              LauncherPlugin    *plugin)
+{
+  gchar    *base_name;
+  gboolean  result;
+
+  panel_return_if_fail (XFCE_IS_LAUNCHER_PLUGIN (plugin));
+  panel_return_if_fail (plugin->config_monitor == monitor);
+
+  /* waited until all events are proccessed */
+  if (event_type != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT
+      && event_type != G_FILE_MONITOR_EVENT_DELETED
+      && event_type != G_FILE_MONITOR_EVENT_CREATED)
+    return;
+
+  /* we only act on desktop files */
+  base_name = g_file_get_basename (changed_file);
+  result = g_str_has_suffix (base_name, ".desktop");
+  g_free (base_name);
+  if (!result)
+    return;
+
+  /* queue the file, multiple events for the same file end up
+   * in the same entry */
+  if (plugin->config_changes == NULL)
+    plugin->config_changes = g_hash_table_new_full (g_file_hash, (GEqualFunc) g_file_equal,
+                                                    g_object_unref, NULL);
+  g_hash_table_add (plugin->config_changes, g_object_ref (G_OBJECT (changed_file)));
+
+  /* handle all the changes in this window at once, the timeout is not
+   * restarted so a continuous stream of events is still processed */
+  if (plugin->config_changes_timeout_id == 0)
+    plugin->config_changes_timeout_id =
+      gdk_threads_add_timeout_full (G_PRIORITY_LOW, CONFIG_CHANGES_DELAY,
+                                    launcher_plugin_file_changes_timeout, plugin,
+                                    launcher_plugin_file_changes_timeout_destroyed);
 }
 
 
@@ -1020,6 +1135,9 @@ launcher_plugin_construct (XfcePanelPlugin *panel_plugin)
   g_free (file);
   g_free (path);
 
+  /* start loading the desktop files of all launchers in the background */
+  launcher_cache_prefetch (xfce_panel_plugin_get_name (panel_plugin));
+
   /* bind all properties */
   panel_properties_bind (NULL, G_OBJECT (plugin),
                          xfce_panel_plugin_get_property_base (panel_plugin),
@@ -1089,6 +1207,9 @@ launcher_plugin_free_data (XfcePanelPlugin *panel_plugin)
       g_object_unref (G_OBJECT (plugin->config_monitor));
     }
 
+  /* drop pending config changes */
+  launcher_plugin_file_changes_cancel (plugin);
+
   if (plugin->save_timeout_id != 0)
     {
       g_source_remove (plugin->save_timeout_id);
@@ -1109,10 +1230,6 @@ launcher_plugin_free_data (XfcePanelPlugin *panel_plugin)
       icon_theme = gtk_icon_theme_get_default ();
       g_signal_handler_disconnect (G_OBJECT (icon_theme), plugin->theme_change_id);
     }
-
-  /* release the cached tooltip */
-  if (plugin->tooltip_cache != NULL)
-    g_object_unref (G_OBJECT (plugin->tooltip_cache));
 }
 
 
@@ -1137,6 +1254,9 @@ launcher_plugin_removed (XfcePanelPlugin *panel_plugin)
       plugin->config_monitor = NULL;
     }
 
+  /* drop pending config changes */
+  launcher_plugin_file_changes_cancel (plugin);
+
   /* cleanup desktop files in the config dir */
   launcher_plugin_items_delete_configs (plugin);
 
@@ -1336,12 +1456,22 @@ launcher_plugin_icon_theme_changed (GtkIconTheme   *icon_theme,
   panel_return_if_fail (XFCE_IS_LAUNCHER_PLUGIN (plugin));
   panel_return_if_fail (GTK_IS_ICON_THEME (icon_theme));
 
-  /* invalid the icon cache */
-  if (plugin->tooltip_cache != NULL)
-    {
-      g_object_unref (G_OBJECT (plugin->tooltip_cache));
-      plugin->tooltip_cache = NULL;
-    }
+  /* rebuild the menu so it picks up the new icons, the icon cache
+   * clears itself */
+  launcher_plugin_menu_destroy (plugin);
+}
+
+
+
+static void
+launcher_plugin_scale_factor_changed (GObject        *object,
+                                      GParamSpec     *pspec,
+                                      LauncherPlugin *plugin)
+{
+  panel_return_if_fail (XFCE_IS_LAUNCHER_PLUGIN (plugin));
+
+  /* rebuild the menu with icons for the new scale */
+  launcher_plugin_menu_destroy (plugin);
 }
 
 
@@ -1402,24 +1532,15 @@ static GdkPixbuf *
 launcher_plugin_tooltip_pixbuf (GdkScreen   *screen,
                                 const gchar *icon_name)
 {
-  GtkIconTheme *theme;
+  gint w, h;
 
   panel_return_val_if_fail (screen == NULL || GDK_IS_SCREEN (screen), NULL);
 
-  if (panel_str_is_empty (icon_name))
-    return NULL;
+  if (!gtk_icon_size_lookup (GTK_ICON_SIZE_DND, &w, &h))
+    w = h = 32;
 
-  /* load directly from a file */
-  if (G_UNLIKELY (g_path_is_absolute (icon_name)))
-    return gdk_pixbuf_new_from_file_at_scale (icon_name, GTK_ICON_SIZE_DND, GTK_ICON_SIZE_DND,
-                                              TRUE, NULL);
-
-  if (G_LIKELY (screen != NULL))
-    theme = gtk_icon_theme_get_for_screen (screen);
-  else
-    theme = gtk_icon_theme_get_default ();
-
-  return gtk_icon_theme_load_icon (theme, icon_name, GTK_ICON_SIZE_DND, 0, NULL);
+  /* tooltip icons are always drawn unscaled */
+  return launcher_cache_get_icon (screen, icon_name, MIN (w, h), 1);
 }
 
 
@@ -1536,14 +1657,22 @@ launcher_plugin_menu_construct (LauncherPlugin *plugin)
 {
   GtkArrowType    arrow_type;
   guint           n;
-  GarconMenuItem *item;
-  GtkWidget      *mi, *box, *label, *image;
-  const gchar    *name, *icon_name;
-  GSList         *li;
+  GarconMenuItem  *item;
+  GtkWidget       *mi, *box, *label, *image;
+  const gchar     *name, *icon_name;
+  GSList          *li;
+  gint             w, h, scale;
+  GdkPixbuf       *pixbuf;
+  cairo_surface_t *surface;
 
   panel_return_if_fail (XFCE_IS_LAUNCHER_PLUGIN (plugin));
   panel_return_if_fail (plugin->menu == NULL);
 
+  /* size of the icons in the menu */
+  if (!gtk_icon_size_lookup (GTK_ICON_SIZE_DND, &w, &h))
+    w = h = 32;
+  scale = gtk_widget_get_scale_factor (GTK_WIDGET (plugin));
+
   /* create a new menu */
   plugin->menu = gtk_menu_new ();
   gtk_menu_attach_to_widget (GTK_MENU (plugin->menu), GTK_WIDGET (plugin), NULL);
@@ -1596,11 +1725,18 @@ launcher_plugin_menu_construct (LauncherPlugin *plugin)
       else
         gtk_menu_shell_append (GTK_MENU_SHELL (plugin->menu), mi);
 
-      /* set the icon if one is set */
+      /* set the icon if one is set, use the pre-scaled icon from
+       * the cache so popping up the menu does not hit the disk */
       icon_name = garcon_menu_item_get_icon_name (item);
-      if (!panel_str_is_empty (icon_name))
+      pixbuf = launcher_cache_get_icon (gtk_widget_get_screen (GTK_WIDGET (plugin)),
+                                        icon_name, MIN (w, h), scale);
+      if (G_LIKELY (pixbuf != NULL))
         {
-          image = gtk_image_new_from_icon_name (icon_name, GTK_ICON_SIZE_DND);
+          surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, scale, NULL);
+          image = gtk_image_new_from_surface (surface);
+          cairo_surface_destroy (surface);
+          g_object_unref (G_OBJECT (pixbuf));
+
           gtk_box_pack_start (GTK_BOX (box), image, FALSE, TRUE, 3);
           gtk_widget_show (image);
         }
@@ -1693,13 +1829,6 @@ launcher_plugin_button_update (LauncherPlugin *plugin)
 
   panel_return_if_fail (XFCE_IS_LAUNCHER_PLUGIN (plugin));
 
-  /* invalate the tooltip icon cache */
-  if (plugin->tooltip_cache != NULL)
-    {
-      g_object_unref (G_OBJECT (plugin->tooltip_cache));
-      plugin->tooltip_cache = NULL;
-    }
-
   /* get first item */
   if (G_LIKELY (plugin->items != NULL))
     item = GARCON_MENU_ITEM (plugin->items->data);
@@ -1846,6 +1975,7 @@ launcher_plugin_button_query_tooltip (GtkWidget      *widget,
 {
   gboolean        result;
   GarconMenuItem *item;
+  GdkPixbuf      *pixbuf;
 
   panel_return_val_if_fail (XFCE_IS_LAUNCHER_PLUGIN (plugin), FALSE);
   panel_return_val_if_fail (!plugin->disable_tooltips, FALSE);
@@ -1863,14 +1993,14 @@ launcher_plugin_button_query_tooltip (GtkWidget      *widget,
   result = launcher_plugin_item_query_tooltip (widget, x, y, keyboard_mode, tooltip, item);
   if (G_LIKELY (result))
     {
-      /* set the cached icon if not already set */
-      if (G_UNLIKELY (plugin->tooltip_cache == NULL))
-        plugin->tooltip_cache =
-            launcher_plugin_tooltip_pixbuf (gtk_widget_get_screen (widget),
-                                            garcon_menu_item_get_icon_name (item));
-
-      if (G_LIKELY (plugin->tooltip_cache != NULL))
-        gtk_tooltip_set_icon (tooltip, plugin->tooltip_cache);
+      /* set the icon from the shared icon cache */
+      pixbuf = launcher_plugin_tooltip_pixbuf (gtk_widget_get_screen (widget),
+                                               garcon_menu_item_get_icon_name (item));
+      if (G_LIKELY (pixbuf != NULL))
+        {
+          gtk_tooltip_set_icon (tooltip, pixbuf);
+          g_object_unref (G_OBJECT (pixbuf));
+        }
     }
 
   return result;
@@ -2250,28 +2380,18 @@ launcher_plugin_item_query_tooltip (GtkWidget      *widget,
       gtk_tooltip_set_text (tooltip, name);
     }
 
-  /* the button uses a custom cache because the button widget is never
-   * destroyed, for menu items we cache the pixbuf by attaching the
-   * data on the menu item widget */
+  /* the button sets its own icon, for menu items we get the icon
+   * from the cache shared by all launchers */
   if (GTK_IS_MENU_ITEM (widget))
     {
-      pixbuf = g_object_get_data (G_OBJECT (widget), "pixbuf-cache");
+      pixbuf = launcher_plugin_tooltip_pixbuf (gtk_widget_get_screen (widget),
+                                               garcon_menu_item_get_icon_name (item));
       if (G_LIKELY (pixbuf != NULL))
         {
           gtk_tooltip_set_icon (tooltip, pixbuf);
+          g_object_unref (G_OBJECT (pixbuf));
         }
-      else
-        {
-          pixbuf = launcher_plugin_tooltip_pixbuf (gtk_widget_get_screen (widget),
-                                                   garcon_menu_item_get_icon_name (item));
-          if (G_LIKELY (pixbuf != NULL))
-            {
-              gtk_tooltip_set_icon (tooltip, pixbuf);
-              g_object_set_data_full (G_OBJECT (widget), "pixbuf-cache", pixbuf,
-                                      (GDestroyNotify) g_object_unref);
-            }
-        }
-     }
+    }
 
   return TRUE;
 }
@@ -2714,6 +2834,36 @@ launcher_plugin_garcon_menu_pool (void)
 
 
 
+static gboolean
+launcher_plugin_garcon_menu_pool_shared_release (gpointer user_data)
+{
+  g_hash_table_unref (launcher_plugin_shared_pool);
+  launcher_plugin_shared_pool = NULL;
+
+  return FALSE;
+}
+
+
+
+static GHashTable *
+launcher_plugin_garcon_menu_pool_shared (void)
+{
+  /* during startup all launchers are constructed before the main loop
+   * becomes idle, so they all share the same pool, after that the pool
+   * is released so new installed applications are picked up */
+  if (launcher_plugin_shared_pool == NULL)
+    {
+      launcher_plugin_shared_pool = launcher_plugin_garcon_menu_pool ();
+      gdk_threads_add_idle_full (G_PRIORITY_LOW,
+                                 launcher_plugin_garcon_menu_pool_shared_release,
+                                 NULL, NULL);
+    }
+
+  return g_hash_table_ref (launcher_plugin_shared_pool);
+}
+
+
+
 gboolean
 launcher_plugin_item_is_editable (LauncherPlugin *plugin,
                                   GarconMenuItem *item,
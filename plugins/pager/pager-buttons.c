@@ -70,6 +70,9 @@ struct _PagerButtons
 
   GSList         *buttons;
 
+  /* whether the buttons are viewports of a single workspace */
+  guint           viewport_mode : 1;
+
   guint           rebuild_id;
 
   WnckScreen     *wnck_screen;
@@ -142,6 +145,7 @@ pager_buttons_init (PagerButtons *pager)
   pager->wnck_screen = NULL;
   pager->orientation = GTK_ORIENTATION_HORIZONTAL;
   pager->buttons = NULL;
+  pager->viewport_mode = FALSE;
   pager->rebuild_id = 0;
 
   /* although I'd prefer normal allocation, the homogeneous setting
@@ -251,6 +255,15 @@ pager_buttons_finalize (GObject *object)
 
 
 
+static void
+pager_buttons_destroy_button (gpointer   workspace,
+                              GtkWidget *button)
+{
+  gtk_widget_destroy (button);
+}
+
+
+
 static gboolean
 pager_buttons_button_press_event (GtkWidget      *button,
                                   GdkEventButton *event)
@@ -272,15 +285,79 @@ pager_buttons_button_press_event (GtkWidget      *button,
 
 
 
+static GtkWidget *
+pager_buttons_button_new (GtkWidget *panel_plugin,
+                          GtkWidget *label)
+{
+  GtkWidget *button;
+
+  button = xfce_panel_create_toggle_button ();
+  g_signal_connect (G_OBJECT (button), "button-press-event",
+      G_CALLBACK (pager_buttons_button_press_event), NULL);
+  xfce_panel_plugin_add_action_widget (XFCE_PANEL_PLUGIN (panel_plugin), button);
+  gtk_widget_show (button);
+
+  gtk_container_add (GTK_CONTAINER (button), label);
+  gtk_widget_show (label);
+
+  return button;
+}
+
+
+
+static void
+pager_buttons_button_attach (PagerButtons *pager,
+                             GtkWidget    *button,
+                             gint          n,
+                             gint          cols)
+{
+  gint row, col;
+  gint left_attach, top_attach;
+
+  if (pager->orientation == GTK_ORIENTATION_HORIZONTAL)
+    {
+      row = n % cols;
+      col = n / cols;
+    }
+  else
+    {
+      row = n / cols;
+      col = n % cols;
+    }
+
+  gtk_label_set_angle (GTK_LABEL (gtk_bin_get_child (GTK_BIN (button))),
+      pager->orientation == GTK_ORIENTATION_HORIZONTAL ? 0 : 270);
+
+  if (gtk_widget_get_parent (button) == NULL)
+    {
+      gtk_grid_attach (GTK_GRID (pager), button,
+                       row, col, 1, 1);
+    }
+  else
+    {
+      /* only move the button if its cell changed */
+      gtk_container_child_get (GTK_CONTAINER (pager), button,
+                               "left-attach", &left_attach,
+                               "top-attach", &top_attach, NULL);
+      if (left_attach != row || top_attach != col)
+        gtk_container_child_set (GTK_CONTAINER (pager), button,
+                                 "left-attach", row,
+                                 "top-attach", col, NULL);
+    }
+}
+
+
+
 static gboolean
 pager_buttons_rebuild_idle (gpointer user_data)
 {
   PagerButtons  *pager = XFCE_PAGER_BUTTONS (user_data);
   GList         *li, *workspaces;
+  GSList        *lp, *buttons = NULL;
+  GHashTable    *existing;
   WnckWorkspace *active_ws;
   gint           n, n_workspaces;
   gint           rows, cols;
-  gint           row, col;
   GtkWidget     *button;
   WnckWorkspace *workspace = NULL;
   GtkWidget     *panel_plugin;
@@ -296,16 +373,18 @@ pager_buttons_rebuild_idle (gpointer user_data)
   panel_return_val_if_fail (XFCE_IS_PAGER_BUTTONS (pager), FALSE);
   panel_return_val_if_fail (WNCK_IS_SCREEN (pager->wnck_screen), FALSE);
 
-  gtk_container_foreach (GTK_CONTAINER (pager),
-      (GtkCallback) gtk_widget_destroy, NULL);
-
-  g_slist_free (pager->buttons);
-  pager->buttons = NULL;
-
   active_ws = wnck_screen_get_active_workspace (pager->wnck_screen);
   workspaces = wnck_screen_get_workspaces (pager->wnck_screen);
   if (workspaces == NULL)
-    goto leave;
+    {
+      gtk_container_foreach (GTK_CONTAINER (pager),
+          (GtkCallback) gtk_widget_destroy, NULL);
+
+      g_slist_free (pager->buttons);
+      pager->buttons = NULL;
+
+      goto leave;
+    }
 
   n_workspaces = g_list_length (workspaces);
 
@@ -351,6 +430,17 @@ pager_buttons_rebuild_idle (gpointer user_data)
         cols++;
     }
 
+  /* the buttons of the other mode cannot be reused */
+  if (pager->viewport_mode != viewport_mode)
+    {
+      gtk_container_foreach (GTK_CONTAINER (pager),
+          (GtkCallback) gtk_widget_destroy, NULL);
+
+      g_slist_free (pager->buttons);
+      pager->buttons = NULL;
+
+      pager->viewport_mode = viewport_mode;
+    }
 
   panel_plugin = gtk_widget_get_ancestor (GTK_WIDGET (pager), XFCE_TYPE_PANEL_PLUGIN);
 
@@ -361,92 +451,94 @@ pager_buttons_rebuild_idle (gpointer user_data)
       viewport_x = wnck_workspace_get_viewport_x (workspace);
       viewport_y = wnck_workspace_get_viewport_y (workspace);
 
-      for (n = 0; n < n_viewports; n++)
+      /* reuse the existing viewport buttons in order */
+      for (n = 0, lp = pager->buttons; n < n_viewports; n++)
         {
-          vp_info = g_new0 (gint, N_INFOS);
-          vp_info[VIEWPORT_X] = (n % (workspace_height / screen_height)) * screen_width;
-          vp_info[VIEWPORT_Y] = (n / (workspace_height / screen_height)) * screen_height;
-
-          button = xfce_panel_create_toggle_button ();
-          if (viewport_x >= vp_info[VIEWPORT_X] && viewport_x < vp_info[VIEWPORT_X] + screen_width
-              && viewport_y >= vp_info[VIEWPORT_Y] && viewport_y < vp_info[VIEWPORT_Y] + screen_height)
-            gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (button), TRUE);
-          g_signal_connect (G_OBJECT (button), "toggled",
-              G_CALLBACK (pager_buttons_viewport_button_toggled), pager);
-          g_signal_connect (G_OBJECT (button), "button-press-event",
-              G_CALLBACK (pager_buttons_button_press_event), NULL);
-          xfce_panel_plugin_add_action_widget (XFCE_PANEL_PLUGIN (panel_plugin), button);
-          gtk_widget_show (button);
-
-          g_object_set_data_full (G_OBJECT (button), "viewport-info", vp_info,
-                                  (GDestroyNotify) g_free);
-
-          g_snprintf (text, sizeof (text), "%d", n + 1);
-          label = gtk_label_new (text);
-          gtk_label_set_angle (GTK_LABEL (label),
-              pager->orientation == GTK_ORIENTATION_HORIZONTAL ? 0 : 270);
-          gtk_container_add (GTK_CONTAINER (button), label);
-          gtk_widget_show (label);
-
-          if (pager->orientation == GTK_ORIENTATION_HORIZONTAL)
+          if (lp != NULL)
             {
-              row = n % cols;
-              col = n / cols;
+              button = GTK_WIDGET (lp->data);
+              lp = lp->next;
             }
           else
             {
-              row = n / cols;
-              col = n % cols;
+              g_snprintf (text, sizeof (text), "%d", n + 1);
+              button = pager_buttons_button_new (panel_plugin, gtk_label_new (text));
+              g_object_set_data_full (G_OBJECT (button), "viewport-info",
+                                      g_new0 (gint, N_INFOS), (GDestroyNotify) g_free);
+              g_signal_connect (G_OBJECT (button), "toggled",
+                  G_CALLBACK (pager_buttons_viewport_button_toggled), pager);
             }
 
-          gtk_grid_attach (GTK_GRID (pager), button,
-                           row, col, 1, 1);
+          vp_info = g_object_get_data (G_OBJECT (button), "viewport-info");
+          vp_info[VIEWPORT_X] = (n % (workspace_height / screen_height)) * screen_width;
+          vp_info[VIEWPORT_Y] = (n / (workspace_height / screen_height)) * screen_height;
+
+          /* update the active viewport without moving the viewport */
+          g_signal_handlers_block_by_func (G_OBJECT (button),
+              pager_buttons_viewport_button_toggled, pager);
+          gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (button),
+              viewport_x >= vp_info[VIEWPORT_X] && viewport_x < vp_info[VIEWPORT_X] + screen_width
+              && viewport_y >= vp_info[VIEWPORT_Y] && viewport_y < vp_info[VIEWPORT_Y] + screen_height);
+          g_signal_handlers_unblock_by_func (G_OBJECT (button),
+              pager_buttons_viewport_button_toggled, pager);
+
+          pager_buttons_button_attach (pager, button, n, cols);
+
+          buttons = g_slist_prepend (buttons, button);
         }
+
+      /* destroy the buttons of removed viewports */
+      for (; lp != NULL; lp = lp->next)
+        gtk_widget_destroy (GTK_WIDGET (lp->data));
     }
   else
     {
+      /* lookup table for the buttons of existing workspaces */
+      existing = g_hash_table_new (g_direct_hash, g_direct_equal);
+      for (lp = pager->buttons; lp != NULL; lp = lp->next)
+        g_hash_table_insert (existing,
+            g_object_get_data (G_OBJECT (lp->data), "workspace"), lp->data);
+
       for (li = workspaces, n = 0; li != NULL; li = li->next, n++)
         {
           workspace = WNCK_WORKSPACE (li->data);
 
-          button = xfce_panel_create_toggle_button ();
-          if (workspace == active_ws)
-            gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (button), TRUE);
-          g_signal_connect (G_OBJECT (button), "toggled",
-              G_CALLBACK (pager_buttons_workspace_button_toggled), workspace);
-          g_signal_connect (G_OBJECT (button), "button-press-event",
-              G_CALLBACK (pager_buttons_button_press_event), NULL);
-          xfce_panel_plugin_add_action_widget (XFCE_PANEL_PLUGIN (panel_plugin), button);
-          gtk_widget_show (button);
-
-          label = gtk_label_new (NULL);
-          g_signal_connect_object (G_OBJECT (workspace), "name-changed",
-              G_CALLBACK (pager_buttons_workspace_button_label), label, 0);
-          pager_buttons_workspace_button_label (workspace, label);
-          gtk_label_set_angle (GTK_LABEL (label),
-              pager->orientation == GTK_ORIENTATION_HORIZONTAL ? 0 : 270);
-          gtk_container_add (GTK_CONTAINER (button), label);
-          gtk_widget_show (label);
-
-          pager->buttons = g_slist_prepend (pager->buttons, button);
-
-          if (pager->orientation == GTK_ORIENTATION_HORIZONTAL)
+          button = g_hash_table_lookup (existing, workspace);
+          if (button != NULL)
             {
-              row = n % cols;
-              col = n / cols;
+              g_hash_table_remove (existing, workspace);
+
+              /* the default name contains the workspace number */
+              pager_buttons_workspace_button_label (workspace,
+                  gtk_bin_get_child (GTK_BIN (button)));
             }
           else
             {
-              row = n / cols;
-              col = n % cols;
+              label = gtk_label_new (NULL);
+              g_signal_connect_object (G_OBJECT (workspace), "name-changed",
+                  G_CALLBACK (pager_buttons_workspace_button_label), label, 0);
+              pager_buttons_workspace_button_label (workspace, label);
+
+              button = pager_buttons_button_new (panel_plugin, label);
+              g_object_set_data (G_OBJECT (button), "workspace", workspace);
+              g_signal_connect (G_OBJECT (button), "toggled",
+                  G_CALLBACK (pager_buttons_workspace_button_toggled), workspace);
             }
 
-          gtk_grid_attach (GTK_GRID (pager), button,
-                           row, col, 1, 1);
+          gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (button), workspace == active_ws);
+
+          pager_buttons_button_attach (pager, button, n, cols);
+
+          buttons = g_slist_prepend (buttons, button);
         }
+
+      /* destroy the buttons of removed workspaces */
+      g_hash_table_foreach (existing, (GHFunc) pager_buttons_destroy_button, NULL);
+      g_hash_table_destroy (existing);
     }
 
-  pager->buttons = g_slist_reverse (pager->buttons);
+  g_slist_free (pager->buttons);
+  pager->buttons = g_slist_reverse (buttons);
 
   leave:
 
@@ -491,6 +583,10 @@ pager_buttons_screen_workspace_changed (WnckScreen    *screen,
   panel_return_if_fail (XFCE_IS_PAGER_BUTTONS (pager));
   panel_return_if_fail (pager->wnck_screen == screen);
 
+  /* viewport buttons are updated in the rebuild */
+  if (pager->viewport_mode)
+    return;
+
   active_ws = wnck_screen_get_active_workspace (screen);
   if (G_LIKELY (active_ws != NULL))
     active = wnck_workspace_get_number (active_ws);
@@ -521,11 +617,27 @@ pager_buttons_screen_workspace_destroyed (WnckScreen    *screen,
                                           WnckWorkspace *destroyed_workspace,
                                           PagerButtons  *pager)
 {
+  GSList *li;
+
   panel_return_if_fail (WNCK_IS_SCREEN (screen));
   panel_return_if_fail (WNCK_IS_WORKSPACE (destroyed_workspace));
   panel_return_if_fail (XFCE_IS_PAGER_BUTTONS (pager));
   panel_return_if_fail (pager->wnck_screen == screen);
 
+  /* destroy the button now, so it is not used with a dead workspace */
+  if (!pager->viewport_mode)
+    {
+      for (li = pager->buttons; li != NULL; li = li->next)
+        {
+          if (g_object_get_data (G_OBJECT (li->data), "workspace") == destroyed_workspace)
+            {
+              gtk_widget_destroy (GTK_WIDGET (li->data));
+              pager->buttons = g_slist_delete_link (pager->buttons, li);
+              break;
+            }
+        }
+    }
+
   pager_buttons_queue_rebuild (pager);
 }
 
@@ -540,8 +652,9 @@ pager_buttons_screen_viewports_changed (WnckScreen    *screen,
   panel_return_if_fail (pager->wnck_screen == screen);
 
   /* yes we are extremely lazy here, but this event is
-   * also emitted when the viewport setup changes... */
-  if (pager->buttons == NULL)
+   * also emitted when the viewport setup changes, the rebuild
+   * only updates what changed */
+  if (pager->buttons == NULL || pager->viewport_mode)
     pager_buttons_queue_rebuild (pager);
 }
 
@@ -567,7 +680,9 @@ pager_buttons_workspace_button_label (WnckWorkspace *workspace,
     name = name_num = g_strdup_printf (_("Workspace %d"),
         wnck_workspace_get_number (workspace) + 1);
 
-  gtk_label_set_text (GTK_LABEL (label), name);
+  /* avoid a relayout if the name did not change */
+  if (g_strcmp0 (gtk_label_get_text (GTK_LABEL (label)), name) != 0)
+    gtk_label_set_text (GTK_LABEL (label), name);
 
   g_free (utf8);
   g_free (name_num);
@@ -0,0 +1,827 @@
+/*
+ * Copyright (C) 2026 Xfce Development Team
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <gtk/gtk.h>
+#include <libxfce4panel/libxfce4panel.h>
+#include <common/panel-private.h>
+
+#include "pager-miniatures.h"
+
+/* spacing between the workspace miniatures */
+#define SPACING (1)
+
+
+
+static void     pager_miniatures_get_property          (GObject         *object,
+                                                        guint            prop_id,
+                                                        GValue          *value,
+                                                        GParamSpec      *pspec);
+static void     pager_miniatures_set_property          (GObject         *object,
+                                                        guint            prop_id,
+                                                        const GValue    *value,
+                                                        GParamSpec      *pspec);
+static void     pager_miniatures_finalize              (GObject         *object);
+static void     pager_miniatures_unrealize             (GtkWidget       *widget);
+static void     pager_miniatures_size_allocate         (GtkWidget       *widget,
+                                                        GtkAllocation   *allocation);
+static gboolean pager_miniatures_draw                  (GtkWidget       *widget,
+                                                        cairo_t         *cr);
+static void     pager_miniatures_style_updated         (GtkWidget       *widget);
+static gboolean pager_miniatures_button_release_event  (GtkWidget       *widget,
+                                                        GdkEventButton  *event);
+static void     pager_miniatures_set_screen            (PagerMiniatures *pager,
+                                                        WnckScreen      *screen);
+static void     pager_miniatures_workspaces_changed    (PagerMiniatures *pager);
+static void     pager_miniatures_invalidate            (PagerMiniatures *pager,
+                                                        gint             n);
+static void     pager_miniatures_window_opened         (WnckScreen      *screen,
+                                                        WnckWindow      *window,
+                                                        PagerMiniatures *pager);
+
+
+
+struct _PagerMiniaturesClass
+{
+  GtkDrawingAreaClass __parent__;
+};
+
+struct _PagerMiniatures
+{
+  GtkDrawingArea  __parent__;
+
+  WnckScreen     *wnck_screen;
+
+  /* cached miniature of each workspace */
+  GArray         *miniatures;
+
+  /* frame clock callback to queue the changed miniatures */
+  guint           tick_id;
+
+  gint            rows;
+  GtkOrientation  orientation;
+};
+
+typedef struct
+{
+  cairo_surface_t *surface;
+  gint             width;
+  gint             height;
+
+  /* the windows on the workspace changed */
+  guint            dirty : 1;
+
+  /* a redraw is queued on the next frame */
+  guint            queued : 1;
+}
+PagerMiniature;
+
+enum
+{
+  PROP_0,
+  PROP_SCREEN,
+  PROP_ROWS,
+  PROP_ORIENTATION
+};
+
+
+
+XFCE_PANEL_DEFINE_TYPE (PagerMiniatures, pager_miniatures, GTK_TYPE_DRAWING_AREA)
+
+
+
+static void
+pager_miniatures_class_init (PagerMiniaturesClass *klass)
+{
+  GObjectClass   *gobject_class;
+  GtkWidgetClass *gtkwidget_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->get_property = pager_miniatures_get_property;
+  gobject_class->set_property = pager_miniatures_set_property;
+  gobject_class->finalize = pager_miniatures_finalize;
+
+  gtkwidget_class = GTK_WIDGET_CLASS (klass);
+  gtkwidget_class->unrealize = pager_miniatures_unrealize;
+  gtkwidget_class->size_allocate = pager_miniatures_size_allocate;
+  gtkwidget_class->draw = pager_miniatures_draw;
+  gtkwidget_class->style_updated = pager_miniatures_style_updated;
+  gtkwidget_class->button_release_event = pager_miniatures_button_release_event;
+
+#if GTK_CHECK_VERSION (3, 20, 0)
+  /* use the same css node as the wnck pager, so the colors set by
+   * the plugin apply to both miniature views */
+  gtk_widget_class_set_css_name (gtkwidget_class, "wnck-pager");
+#endif
+
+  g_object_class_install_property (gobject_class,
+                                   PROP_SCREEN,
+                                   g_param_spec_object ("screen",
+                                                         NULL, NULL,
+                                                         WNCK_TYPE_SCREEN,
+                                                         G_PARAM_WRITABLE | G_PARAM_STATIC_STRINGS
+                                                         | G_PARAM_CONSTRUCT_ONLY));
+
+  g_object_class_install_property (gobject_class,
+                                   PROP_ROWS,
+                                   g_param_spec_int ("rows",
+                                                     NULL, NULL,
+                                                     1, 100, 1,
+                                                     G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+                                   PROP_ORIENTATION,
+                                   g_param_spec_enum ("orientation",
+                                                     NULL, NULL,
+                                                     GTK_TYPE_ORIENTATION,
+                                                     GTK_ORIENTATION_HORIZONTAL,
+                                                     G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+}
+
+
+
+static void
+pager_miniatures_init (PagerMiniatures *pager)
+{
+  pager->rows = 1;
+  pager->wnck_screen = NULL;
+  pager->orientation = GTK_ORIENTATION_HORIZONTAL;
+  pager->miniatures = g_array_new (FALSE, TRUE, sizeof (PagerMiniature));
+  pager->tick_id = 0;
+
+  gtk_widget_add_events (GTK_WIDGET (pager),
+                         GDK_BUTTON_PRESS_MASK | GDK_BUTTON_RELEASE_MASK);
+}
+
+
+
+static void
+pager_miniatures_get_property (GObject    *object,
+                               guint       prop_id,
+                               GValue     *value,
+                               GParamSpec *pspec)
+{
+  PagerMiniatures *pager = XFCE_PAGER_MINIATURES (object);
+
+  switch (prop_id)
+    {
+    case PROP_ROWS:
+      g_value_set_int (value, pager->rows);
+      break;
+
+    case PROP_ORIENTATION:
+      g_value_set_enum (value, pager->orientation);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+
+
+static void
+pager_miniatures_set_property (GObject      *object,
+                               guint         prop_id,
+                               const GValue *value,
+                               GParamSpec   *pspec)
+{
+  PagerMiniatures *pager = XFCE_PAGER_MINIATURES (object);
+
+  switch (prop_id)
+    {
+    case PROP_SCREEN:
+      pager_miniatures_set_screen (pager, g_value_get_object (value));
+      break;
+
+    case PROP_ROWS:
+      pager_miniatures_set_n_rows (pager, g_value_get_int (value));
+      break;
+
+    case PROP_ORIENTATION:
+      pager_miniatures_set_orientation (pager, g_value_get_enum (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+
+
+static void
+pager_miniatures_surfaces_free (PagerMiniatures *pager)
+{
+  PagerMiniature *miniature;
+  guint           n;
+
+  for (n = 0; n < pager->miniatures->len; n++)
+    {
+      miniature = &g_array_index (pager->miniatures, PagerMiniature, n);
+      if (miniature->surface != NULL)
+        {
+          cairo_surface_destroy (miniature->surface);
+          miniature->surface = NULL;
+        }
+    }
+}
+
+
+
+static void
+pager_miniatures_finalize (GObject *object)
+{
+  PagerMiniatures *pager = XFCE_PAGER_MINIATURES (object);
+  GList           *li;
+
+  if (pager->tick_id != 0)
+    gtk_widget_remove_tick_callback (GTK_WIDGET (pager), pager->tick_id);
+
+  if (G_LIKELY (pager->wnck_screen != NULL))
+    {
+      for (li = wnck_screen_get_windows (pager->wnck_screen); li != NULL; li = li->next)
+        g_signal_handlers_disconnect_by_data (G_OBJECT (li->data), pager);
+      g_signal_handlers_disconnect_by_data (G_OBJECT (pager->wnck_screen), pager);
+
+      g_object_unref (G_OBJECT (pager->wnck_screen));
+    }
+
+  pager_miniatures_surfaces_free (pager);
+  g_array_free (pager->miniatures, TRUE);
+
+  (*G_OBJECT_CLASS (pager_miniatures_parent_class)->finalize) (object);
+}
+
+
+
+static void
+pager_miniatures_unrealize (GtkWidget *widget)
+{
+  PagerMiniatures *pager = XFCE_PAGER_MINIATURES (widget);
+
+  /* the surfaces are similar to the window */
+  pager_miniatures_surfaces_free (pager);
+
+  (*GTK_WIDGET_CLASS (pager_miniatures_parent_class)->unrealize) (widget);
+}
+
+
+
+static void
+pager_miniatures_size_allocate (GtkWidget     *widget,
+                                GtkAllocation *allocation)
+{
+  GtkAllocation old_allocation;
+
+  gtk_widget_get_allocation (widget, &old_allocation);
+
+  (*GTK_WIDGET_CLASS (pager_miniatures_parent_class)->size_allocate) (widget, allocation);
+
+  /* the surfaces are rendered again for the new cell size */
+  if (old_allocation.width != allocation->width
+      || old_allocation.height != allocation->height)
+    pager_miniatures_invalidate (XFCE_PAGER_MINIATURES (widget), -1);
+}
+
+
+
+static void
+pager_miniatures_get_layout (PagerMiniatures *pager,
+                             gint            *n_rows,
+                             gint            *n_cols)
+{
+  gint n_workspaces = MAX (1, pager->miniatures->len);
+  gint rows, cols;
+
+  rows = CLAMP (pager->rows, 1, n_workspaces);
+  cols = (n_workspaces + rows - 1) / rows;
+
+  /* the rows of a vertical pager are columns */
+  if (pager->orientation == GTK_ORIENTATION_HORIZONTAL)
+    {
+      *n_rows = rows;
+      *n_cols = cols;
+    }
+  else
+    {
+      *n_rows = cols;
+      *n_cols = rows;
+    }
+}
+
+
+
+static void
+pager_miniatures_get_cell (PagerMiniatures *pager,
+                           gint             n,
+                           GdkRectangle    *area)
+{
+  GtkAllocation allocation;
+  gint          n_rows, n_cols;
+  gint          row, col;
+
+  gtk_widget_get_allocation (GTK_WIDGET (pager), &allocation);
+  pager_miniatures_get_layout (pager, &n_rows, &n_cols);
+
+  if (pager->orientation == GTK_ORIENTATION_HORIZONTAL)
+    {
+      row = n / n_cols;
+      col = n % n_cols;
+    }
+  else
+    {
+      row = n % n_rows;
+      col = n / n_rows;
+    }
+
+  area->x = col * allocation.width / n_cols;
+  area->y = row * allocation.height / n_rows;
+  area->width = (col + 1) * allocation.width / n_cols - area->x;
+  area->height = (row + 1) * allocation.height / n_rows - area->y;
+
+  /* leave some space between the workspaces */
+  if (col + 1 < n_cols)
+    area->width = MAX (1, area->width - SPACING);
+  if (row + 1 < n_rows)
+    area->height = MAX (1, area->height - SPACING);
+}
+
+
+
+static void
+pager_miniatures_render (PagerMiniatures *pager,
+                         PagerMiniature  *miniature,
+                         gint             n,
+                         gint             width,
+                         gint             height)
+{
+  GtkWidget       *widget = GTK_WIDGET (pager);
+  GtkStyleContext *context;
+  GdkRGBA          fg;
+  WnckWorkspace   *workspace;
+  WnckWindow      *window;
+  GList           *li;
+  cairo_t         *cr;
+  gdouble          scale_x, scale_y;
+  gint             offset_x, offset_y;
+  gint             x, y, w, h;
+
+  if (miniature->surface != NULL)
+    cairo_surface_destroy (miniature->surface);
+
+  miniature->surface = gdk_window_create_similar_surface (gtk_widget_get_window (widget),
+                                                          CAIRO_CONTENT_COLOR_ALPHA,
+                                                          width, height);
+  miniature->width = width;
+  miniature->height = height;
+  miniature->dirty = FALSE;
+
+  workspace = wnck_screen_get_workspace (pager->wnck_screen, n);
+  if (G_UNLIKELY (workspace == NULL))
+    return;
+
+  context = gtk_widget_get_style_context (widget);
+  gtk_style_context_get_color (context, GTK_STATE_FLAG_NORMAL, &fg);
+
+  /* windows are positioned relative to the viewport */
+  scale_x = (gdouble) width / MAX (1, wnck_workspace_get_width (workspace));
+  scale_y = (gdouble) height / MAX (1, wnck_workspace_get_height (workspace));
+  offset_x = wnck_workspace_get_viewport_x (workspace);
+  offset_y = wnck_workspace_get_viewport_y (workspace);
+
+  cr = cairo_create (miniature->surface);
+  cairo_set_line_width (cr, 1.0);
+
+  /* draw the windows from bottom to top, each window covers the
+   * windows below it */
+  for (li = wnck_screen_get_windows_stacked (pager->wnck_screen); li != NULL; li = li->next)
+    {
+      window = WNCK_WINDOW (li->data);
+
+      if (wnck_window_is_skip_pager (window)
+          || !wnck_window_is_visible_on_workspace (window, workspace))
+        continue;
+
+      wnck_window_get_geometry (window, &x, &y, &w, &h);
+
+      x = (x + offset_x) * scale_x;
+      y = (y + offset_y) * scale_y;
+      w = MAX (2, w * scale_x);
+      h = MAX (2, h * scale_y);
+
+      cairo_rectangle (cr, x + 0.5, y + 0.5, w - 1, h - 1);
+
+      cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+      cairo_set_source_rgba (cr, fg.red, fg.green, fg.blue, fg.alpha * 0.25);
+      cairo_fill_preserve (cr);
+
+      cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+      cairo_set_source_rgba (cr, fg.red, fg.green, fg.blue, fg.alpha * 0.8);
+      cairo_stroke (cr);
+    }
+
+  cairo_destroy (cr);
+}
+
+
+
+static gboolean
+pager_miniatures_draw (GtkWidget *widget,
+                       cairo_t   *cr)
+{
+  PagerMiniatures *pager = XFCE_PAGER_MINIATURES (widget);
+  PagerMiniature  *miniature;
+  GtkStyleContext *context;
+  WnckWorkspace   *active_ws;
+  GdkRectangle     clip, area;
+  gint             active = -1;
+  guint            n;
+
+  panel_return_val_if_fail (WNCK_IS_SCREEN (pager->wnck_screen), FALSE);
+
+  if (!gdk_cairo_get_clip_rectangle (cr, &clip))
+    return FALSE;
+
+  active_ws = wnck_screen_get_active_workspace (pager->wnck_screen);
+  if (G_LIKELY (active_ws != NULL))
+    active = wnck_workspace_get_number (active_ws);
+
+  context = gtk_widget_get_style_context (widget);
+
+  for (n = 0; n < pager->miniatures->len; n++)
+    {
+      pager_miniatures_get_cell (pager, n, &area);
+      if (!gdk_rectangle_intersect (&clip, &area, NULL))
+        continue;
+
+      gtk_style_context_save (context);
+      gtk_style_context_set_state (context, (gint) n == active ?
+                                   GTK_STATE_FLAG_SELECTED : GTK_STATE_FLAG_NORMAL);
+      gtk_render_background (context, cr, area.x, area.y, area.width, area.height);
+      gtk_style_context_restore (context);
+
+      /* only render the windows again if they changed, the background
+       * of the active workspace is cheap to paint */
+      miniature = &g_array_index (pager->miniatures, PagerMiniature, n);
+      if (miniature->surface == NULL
+          || miniature->dirty
+          || miniature->width != area.width
+          || miniature->height != area.height)
+        pager_miniatures_render (pager, miniature, n, area.width, area.height);
+
+      cairo_set_source_surface (cr, miniature->surface, area.x, area.y);
+      cairo_paint (cr);
+    }
+
+  return FALSE;
+}
+
+
+
+static void
+pager_miniatures_style_updated (GtkWidget *widget)
+{
+  (*GTK_WIDGET_CLASS (pager_miniatures_parent_class)->style_updated) (widget);
+
+  /* the window colors changed */
+  pager_miniatures_invalidate (XFCE_PAGER_MINIATURES (widget), -1);
+}
+
+
+
+static gboolean
+pager_miniatures_button_release_event (GtkWidget      *widget,
+                                       GdkEventButton *event)
+{
+  PagerMiniatures *pager = XFCE_PAGER_MINIATURES (widget);
+  WnckWorkspace   *workspace;
+  GdkRectangle     area;
+  guint            n;
+
+  if (event->button != 1)
+    return FALSE;
+
+  for (n = 0; n < pager->miniatures->len; n++)
+    {
+      pager_miniatures_get_cell (pager, n, &area);
+      if (event->x >= area.x && event->x < area.x + area.width
+          && event->y >= area.y && event->y < area.y + area.height)
+        {
+          workspace = wnck_screen_get_workspace (pager->wnck_screen, n);
+          if (workspace != NULL
+              && workspace != wnck_screen_get_active_workspace (pager->wnck_screen))
+            wnck_workspace_activate (workspace, event->time);
+
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+
+
+static gboolean
+pager_miniatures_tick (GtkWidget     *widget,
+                       GdkFrameClock *frame_clock,
+                       gpointer       user_data)
+{
+  PagerMiniatures *pager = XFCE_PAGER_MINIATURES (widget);
+  PagerMiniature  *miniature;
+  GdkRectangle     area;
+  guint            n;
+
+  pager->tick_id = 0;
+
+  /* queue a redraw for the workspaces that changed in the last frame,
+   * the draw renders each of them once */
+  for (n = 0; n < pager->miniatures->len; n++)
+    {
+      miniature = &g_array_index (pager->miniatures, PagerMiniature, n);
+      if (miniature->queued)
+        {
+          miniature->queued = FALSE;
+
+          pager_miniatures_get_cell (pager, n, &area);
+          gtk_widget_queue_draw_area (widget, area.x, area.y, area.width, area.height);
+        }
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+
+
+static void
+pager_miniatures_invalidate (PagerMiniatures *pager,
+                             gint             n)
+{
+  PagerMiniature *miniature;
+  guint           i;
+
+  /* a negative or unknown number invalidates all workspaces */
+  for (i = 0; i < pager->miniatures->len; i++)
+    {
+      if (n >= 0 && n < (gint) pager->miniatures->len && (gint) i != n)
+        continue;
+
+      miniature = &g_array_index (pager->miniatures, PagerMiniature, i);
+      miniature->dirty = TRUE;
+      miniature->queued = TRUE;
+    }
+
+  /* window geometries change continuously while they are moved or
+   * resized, so only queue a redraw once for each frame */
+  if (pager->tick_id == 0)
+    pager->tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (pager),
+                                                   pager_miniatures_tick,
+                                                   NULL, NULL);
+}
+
+
+
+static void
+pager_miniatures_invalidate_window (PagerMiniatures *pager,
+                                    WnckWindow      *window)
+{
+  WnckWorkspace *workspace;
+
+  /* pinned windows are shown on all workspaces */
+  workspace = wnck_window_get_workspace (window);
+  pager_miniatures_invalidate (pager, workspace != NULL && !wnck_window_is_pinned (window) ?
+                               wnck_workspace_get_number (workspace) : -1);
+}
+
+
+
+static void
+pager_miniatures_window_geometry_changed (WnckWindow      *window,
+                                          PagerMiniatures *pager)
+{
+  panel_return_if_fail (XFCE_IS_PAGER_MINIATURES (pager));
+
+  pager_miniatures_invalidate_window (pager, window);
+}
+
+
+
+static void
+pager_miniatures_window_state_changed (WnckWindow      *window,
+                                       WnckWindowState  changed_mask,
+                                       WnckWindowState  new_state,
+                                       PagerMiniatures *pager)
+{
+  panel_return_if_fail (XFCE_IS_PAGER_MINIATURES (pager));
+
+  /* only these states change the visibility in the pager */
+  if (PANEL_HAS_FLAG (changed_mask, WNCK_WINDOW_STATE_MINIMIZED
+                                    | WNCK_WINDOW_STATE_SKIP_PAGER
+                                    | WNCK_WINDOW_STATE_HIDDEN))
+    pager_miniatures_invalidate_window (pager, window);
+}
+
+
+
+static void
+pager_miniatures_window_workspace_changed (WnckWindow      *window,
+                                           PagerMiniatures *pager)
+{
+  panel_return_if_fail (XFCE_IS_PAGER_MINIATURES (pager));
+
+  /* we don't know the previous workspace */
+  pager_miniatures_invalidate (pager, -1);
+}
+
+
+
+static void
+pager_miniatures_window_opened (WnckScreen      *screen,
+                                WnckWindow      *window,
+                                PagerMiniatures *pager)
+{
+  panel_return_if_fail (XFCE_IS_PAGER_MINIATURES (pager));
+  panel_return_if_fail (WNCK_IS_WINDOW (window));
+
+  g_signal_connect (G_OBJECT (window), "geometry-changed",
+      G_CALLBACK (pager_miniatures_window_geometry_changed), pager);
+  g_signal_connect (G_OBJECT (window), "state-changed",
+      G_CALLBACK (pager_miniatures_window_state_changed), pager);
+  g_signal_connect (G_OBJECT (window), "workspace-changed",
+      G_CALLBACK (pager_miniatures_window_workspace_changed), pager);
+
+  pager_miniatures_invalidate_window (pager, window);
+}
+
+
+
+static void
+pager_miniatures_window_closed (WnckScreen      *screen,
+                                WnckWindow      *window,
+                                PagerMiniatures *pager)
+{
+  panel_return_if_fail (XFCE_IS_PAGER_MINIATURES (pager));
+  panel_return_if_fail (WNCK_IS_WINDOW (window));
+
+  g_signal_handlers_disconnect_by_data (G_OBJECT (window), pager);
+
+  pager_miniatures_invalidate_window (pager, window);
+}
+
+
+
+static void
+pager_miniatures_stacking_changed (WnckScreen      *screen,
+                                   PagerMiniatures *pager)
+{
+  panel_return_if_fail (XFCE_IS_PAGER_MINIATURES (pager));
+
+  pager_miniatures_invalidate (pager, -1);
+}
+
+
+
+static void
+pager_miniatures_active_workspace_changed (WnckScreen      *screen,
+                                           WnckWorkspace   *previous_workspace,
+                                           PagerMiniatures *pager)
+{
+  panel_return_if_fail (XFCE_IS_PAGER_MINIATURES (pager));
+
+  /* only the backgrounds change, the cached windows are reused */
+  gtk_widget_queue_draw (GTK_WIDGET (pager));
+}
+
+
+
+static void
+pager_miniatures_workspace_added (WnckScreen      *screen,
+                                  WnckWorkspace   *workspace,
+                                  PagerMiniatures *pager)
+{
+  /* also used for destroyed workspaces, the cells are rebuilt from
+   * the workspace count */
+  pager_miniatures_workspaces_changed (pager);
+}
+
+
+
+static void
+pager_miniatures_workspaces_changed (PagerMiniatures *pager)
+{
+  gint n_workspaces;
+
+  panel_return_if_fail (XFCE_IS_PAGER_MINIATURES (pager));
+  panel_return_if_fail (WNCK_IS_SCREEN (pager->wnck_screen));
+
+  n_workspaces = wnck_screen_get_workspace_count (pager->wnck_screen);
+  if ((gint) pager->miniatures->len == n_workspaces)
+    {
+      pager_miniatures_invalidate (pager, -1);
+      return;
+    }
+
+  /* the layout changed, so all the cells are rendered again */
+  pager_miniatures_surfaces_free (pager);
+  g_array_set_size (pager->miniatures, n_workspaces);
+  pager_miniatures_invalidate (pager, -1);
+
+  gtk_widget_queue_resize (GTK_WIDGET (pager));
+}
+
+
+
+static void
+pager_miniatures_set_screen (PagerMiniatures *pager,
+                             WnckScreen      *screen)
+{
+  GList *li;
+
+  panel_return_if_fail (XFCE_IS_PAGER_MINIATURES (pager));
+  panel_return_if_fail (WNCK_IS_SCREEN (screen));
+  panel_return_if_fail (pager->wnck_screen == NULL);
+
+  pager->wnck_screen = g_object_ref (G_OBJECT (screen));
+
+  g_signal_connect (G_OBJECT (screen), "active-workspace-changed",
+      G_CALLBACK (pager_miniatures_active_workspace_changed), pager);
+  g_signal_connect (G_OBJECT (screen), "workspace-created",
+      G_CALLBACK (pager_miniatures_workspace_added), pager);
+  g_signal_connect (G_OBJECT (screen), "workspace-destroyed",
+      G_CALLBACK (pager_miniatures_workspace_added), pager);
+  g_signal_connect_swapped (G_OBJECT (screen), "viewports-changed",
+      G_CALLBACK (pager_miniatures_workspaces_changed), pager);
+  g_signal_connect (G_OBJECT (screen), "window-stacking-changed",
+      G_CALLBACK (pager_miniatures_stacking_changed), pager);
+  g_signal_connect (G_OBJECT (screen), "window-opened",
+      G_CALLBACK (pager_miniatures_window_opened), pager);
+  g_signal_connect (G_OBJECT (screen), "window-closed",
+      G_CALLBACK (pager_miniatures_window_closed), pager);
+
+  for (li = wnck_screen_get_windows (screen); li != NULL; li = li->next)
+    pager_miniatures_window_opened (screen, WNCK_WINDOW (li->data), pager);
+
+  pager_miniatures_workspaces_changed (pager);
+}
+
+
+
+GtkWidget *
+pager_miniatures_new (WnckScreen *screen)
+{
+  panel_return_val_if_fail (WNCK_IS_SCREEN (screen), NULL);
+
+  return g_object_new (XFCE_TYPE_PAGER_MINIATURES,
+                       "screen", screen, NULL);
+}
+
+
+
+void
+pager_miniatures_set_orientation (PagerMiniatures *pager,
+                                  GtkOrientation   orientation)
+{
+  panel_return_if_fail (XFCE_IS_PAGER_MINIATURES (pager));
+
+  if (pager->orientation == orientation)
+   return;
+
+  pager->orientation = orientation;
+  pager_miniatures_invalidate (pager, -1);
+  gtk_widget_queue_resize (GTK_WIDGET (pager));
+}
+
+
+
+void
+pager_miniatures_set_n_rows (PagerMiniatures *pager,
+                             gint             rows)
+{
+  panel_return_if_fail (XFCE_IS_PAGER_MINIATURES (pager));
+
+  if (pager->rows == rows)
+   return;
+
+  pager->rows = rows;
+  pager_miniatures_invalidate (pager, -1);
+  gtk_widget_queue_resize (GTK_WIDGET (pager));
+}
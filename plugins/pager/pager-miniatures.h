@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2026 Xfce Development Team
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __PAGER_MINIATURES_H__
+#define __PAGER_MINIATURES_H__
+
+#include <gtk/gtk.h>
+#include <libwnck/libwnck.h>
+
+G_BEGIN_DECLS
+
+typedef struct _PagerMiniaturesClass PagerMiniaturesClass;
+typedef struct _PagerMiniatures      PagerMiniatures;
+
+#define XFCE_TYPE_PAGER_MINIATURES            (pager_miniatures_get_type ())
+#define XFCE_PAGER_MINIATURES(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), XFCE_TYPE_PAGER_MINIATURES, PagerMiniatures))
+#define XFCE_PAGER_MINIATURES_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), XFCE_TYPE_PAGER_MINIATURES, PagerMiniaturesClass))
+#define XFCE_IS_PAGER_MINIATURES(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), XFCE_TYPE_PAGER_MINIATURES))
+#define XFCE_IS_PAGER_MINIATURES_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), XFCE_TYPE_PAGER_MINIATURES))
+#define XFCE_PAGER_MINIATURES_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), XFCE_TYPE_PAGER_MINIATURES, PagerMiniaturesClass))
+
+GType      pager_miniatures_get_type        (void) G_GNUC_CONST;
+
+void       pager_miniatures_register_type   (XfcePanelTypeModule *type_module);
+
+GtkWidget *pager_miniatures_new             (WnckScreen          *screen) G_GNUC_MALLOC;
+
+void       pager_miniatures_set_orientation (PagerMiniatures     *pager,
+                                             GtkOrientation       orientation);
+
+void       pager_miniatures_set_n_rows      (PagerMiniatures     *pager,
+                                             gint                 rows);
+
+G_END_DECLS
+
+#endif /* !__PAGER_MINIATURES_H__ */
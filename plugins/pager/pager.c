@@ -36,6 +36,7 @@
 
 #include "pager.h"
 #include "pager-buttons.h"
+#include "pager-miniatures.h"
 #include "pager-dialog_ui.h"
 
 
@@ -101,6 +102,7 @@ struct _PagerPlugin
   guint          scrolling : 1;
   guint          wrap_workspaces : 1;
   guint          miniature_view : 1;
+  guint          cached_miniatures : 1;
   gint           rows;
   gfloat         ratio;
 };
@@ -111,6 +113,7 @@ enum
   PROP_WORKSPACE_SCROLLING,
   PROP_WRAP_WORKSPACES,
   PROP_MINIATURE_VIEW,
+  PROP_CACHED_MINIATURES,
   PROP_ROWS
 };
 
@@ -118,7 +121,8 @@ enum
 
 /* define the plugin */
 XFCE_PANEL_DEFINE_PLUGIN_RESIDENT (PagerPlugin, pager_plugin,
-    pager_buttons_register_type)
+    pager_buttons_register_type,
+    pager_miniatures_register_type)
 
 
 
@@ -168,6 +172,13 @@ pager_plugin_class_init (PagerPluginClass *klass)
                                                          TRUE,
                                                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class,
+                                   PROP_CACHED_MINIATURES,
+                                   g_param_spec_boolean ("cached-miniatures",
+                                                         NULL, NULL,
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   g_object_class_install_property (gobject_class,
                                    PROP_ROWS,
                                    g_param_spec_uint ("rows",
@@ -185,6 +196,7 @@ pager_plugin_init (PagerPlugin *plugin)
   plugin->scrolling = TRUE;
   plugin->wrap_workspaces = FALSE;
   plugin->miniature_view = TRUE;
+  plugin->cached_miniatures = FALSE;
   plugin->rows = 1;
   plugin->ratio = 1.0;
   plugin->pager = NULL;
@@ -216,6 +228,10 @@ pager_plugin_get_property (GObject    *object,
       pager_plugin_screen_layout_changed (plugin);
       break;
 
+    case PROP_CACHED_MINIATURES:
+      g_value_set_boolean (value, plugin->cached_miniatures);
+      break;
+
     case PROP_ROWS:
       g_value_set_uint (value, plugin->rows);
       break;
@@ -250,17 +266,26 @@ pager_plugin_set_property (GObject      *object,
       plugin->miniature_view = g_value_get_boolean (value);
       break;
 
+    case PROP_CACHED_MINIATURES:
+      plugin->cached_miniatures = g_value_get_boolean (value);
+
+      if (plugin->pager != NULL && plugin->miniature_view)
+        pager_plugin_screen_layout_changed (plugin);
+      break;
+
     case PROP_ROWS:
       plugin->rows = g_value_get_uint (value);
 
       if (plugin->pager != NULL)
         {
-          if (plugin->miniature_view)
+          if (WNCK_IS_PAGER (plugin->pager))
             {
               if (!wnck_pager_set_n_rows (WNCK_PAGER (plugin->pager), plugin->rows))
                 g_message ("Failed to set the number of pager rows. You probably "
                            "have more than 1 pager in your panel setup.");
             }
+          else if (XFCE_IS_PAGER_MINIATURES (plugin->pager))
+            pager_miniatures_set_n_rows (XFCE_PAGER_MINIATURES (plugin->pager), plugin->rows);
           else
             pager_buttons_set_n_rows (XFCE_PAGER_BUTTONS (plugin->pager), plugin->rows);
         }
@@ -380,7 +405,14 @@ pager_plugin_screen_layout_changed (PagerPlugin *plugin)
     (mode != XFCE_PANEL_PLUGIN_MODE_VERTICAL) ?
     GTK_ORIENTATION_HORIZONTAL : GTK_ORIENTATION_VERTICAL;
 
-  if (plugin->miniature_view)
+  if (plugin->miniature_view && plugin->cached_miniatures)
+    {
+      plugin->pager = pager_miniatures_new (plugin->wnck_screen);
+      pager_miniatures_set_n_rows (XFCE_PAGER_MINIATURES (plugin->pager), plugin->rows);
+      pager_miniatures_set_orientation (XFCE_PAGER_MINIATURES (plugin->pager), orientation);
+      plugin->ratio = (gfloat) gdk_screen_width () / (gfloat) gdk_screen_height ();
+    }
+  else if (plugin->miniature_view)
     {
       plugin->pager = wnck_pager_new ();
       wnck_pager_set_display_mode (WNCK_PAGER (plugin->pager), WNCK_PAGER_DISPLAY_CONTENT);
@@ -439,6 +471,7 @@ pager_plugin_construct (XfcePanelPlugin *panel_plugin)
     { "workspace-scrolling", G_TYPE_BOOLEAN },
     { "wrap-workspaces", G_TYPE_BOOLEAN },
     { "miniature-view", G_TYPE_BOOLEAN },
+    { "cached-miniatures", G_TYPE_BOOLEAN },
     { "rows", G_TYPE_UINT },
     { NULL }
   };
@@ -506,8 +539,10 @@ pager_plugin_mode_changed (XfcePanelPlugin     *panel_plugin,
     (mode != XFCE_PANEL_PLUGIN_MODE_VERTICAL) ?
     GTK_ORIENTATION_HORIZONTAL : GTK_ORIENTATION_VERTICAL;
 
-  if (plugin->miniature_view)
+  if (WNCK_IS_PAGER (plugin->pager))
     wnck_pager_set_orientation (WNCK_PAGER (plugin->pager), orientation);
+  else if (XFCE_IS_PAGER_MINIATURES (plugin->pager))
+    pager_miniatures_set_orientation (XFCE_PAGER_MINIATURES (plugin->pager), orientation);
   else
     pager_buttons_set_orientation (XFCE_PAGER_BUTTONS (plugin->pager), orientation);
 }
@@ -628,6 +663,15 @@ pager_plugin_configure_plugin (XfcePanelPlugin *panel_plugin)
                           G_OBJECT (object), "active",
                           G_BINDING_SYNC_CREATE | G_BINDING_BIDIRECTIONAL);
 
+  object = gtk_builder_get_object (builder, "cached-miniatures");
+  panel_return_if_fail (GTK_IS_TOGGLE_BUTTON (object));
+  g_object_bind_property (G_OBJECT (plugin), "cached-miniatures",
+                          G_OBJECT (object), "active",
+                          G_BINDING_SYNC_CREATE | G_BINDING_BIDIRECTIONAL);
+  g_object_bind_property (G_OBJECT (plugin), "miniature-view",
+                          G_OBJECT (object), "sensitive",
+                          G_BINDING_SYNC_CREATE);
+
   object = gtk_builder_get_object (builder, "rows");
   panel_return_if_fail (GTK_IS_ADJUSTMENT (object));
   g_object_bind_property (G_OBJECT (plugin), "rows",
@@ -34,6 +34,7 @@
 
 #include "systray-box.h"
 #include "systray-socket.h"
+#include "systray-sni-item.h"
 
 #define SPACING    (2)
 #define OFFSCREEN  (-9999)
@@ -68,6 +69,8 @@ static void     systray_box_forall                (GtkContainer    *container,
                                                    GtkCallback      callback,
                                                    gpointer         callback_data);
 static GType    systray_box_child_type            (GtkContainer    *container);
+static gboolean systray_box_child_get_hidden      (GtkWidget       *child);
+static const gchar *systray_box_child_get_name    (GtkWidget       *child);
 static gint     systray_box_compare_function      (gconstpointer    a,
                                                    gconstpointer    b);
 
@@ -325,7 +328,8 @@ systray_box_get_preferred_length (GtkWidget      *widget,
   for (li = box->childeren, cells = 0.00; li != NULL; li = li->next)
     {
       child = GTK_WIDGET (li->data);
-      panel_return_if_fail (XFCE_IS_SYSTRAY_SOCKET (child));
+      panel_return_if_fail (XFCE_IS_SYSTRAY_SOCKET (child)
+                            || XFCE_IS_SYSTRAY_SNI_ITEM (child));
 
       gtk_widget_get_preferred_size (child, NULL, &child_req);
 
@@ -334,7 +338,7 @@ systray_box_get_preferred_length (GtkWidget      *widget,
           || !gtk_widget_get_visible (child))
         continue;
 
-      hidden = systray_socket_get_hidden (XFCE_SYSTRAY_SOCKET (child));
+      hidden = systray_box_child_get_hidden (child);
       if (hidden)
         n_hidden_childeren++;
 
@@ -476,7 +480,8 @@ systray_box_size_allocate (GtkWidget     *widget,
   for (li = box->childeren; li != NULL; li = li->next)
     {
       child = GTK_WIDGET (li->data);
-      panel_return_if_fail (XFCE_IS_SYSTRAY_SOCKET (child));
+      panel_return_if_fail (XFCE_IS_SYSTRAY_SOCKET (child)
+                            || XFCE_IS_SYSTRAY_SNI_ITEM (child));
 
       if (!gtk_widget_get_visible (child))
         continue;
@@ -485,7 +490,7 @@ systray_box_size_allocate (GtkWidget     *widget,
 
       if (REQUISITION_IS_INVISIBLE (child_req)
           || (!box->show_hidden
-              && systray_socket_get_hidden (XFCE_SYSTRAY_SOCKET (child))))
+              && systray_box_child_get_hidden (child)))
         {
           /* position hidden icons offscreen if we don't show hidden icons
            * or the requested size looks like an invisible icons (see macro) */
@@ -605,7 +610,7 @@ systray_box_size_allocate (GtkWidget     *widget,
         }
 
       panel_debug_filtered (PANEL_DEBUG_SYSTRAY, "allocated %s[%p] at (%d,%d;%d,%d)",
-          systray_socket_get_name (XFCE_SYSTRAY_SOCKET (child)), child,
+          systray_box_child_get_name (child), child,
           child_alloc.x, child_alloc.y, child_alloc.width, child_alloc.height);
 
       gtk_widget_size_allocate (child, &child_alloc);
@@ -686,6 +691,29 @@ systray_box_child_type (GtkContainer *container)
 
 
 
+static gboolean
+systray_box_child_get_hidden (GtkWidget *child)
+{
+  /* the box contains xembed sockets and status notifier items */
+  if (XFCE_IS_SYSTRAY_SNI_ITEM (child))
+    return systray_sni_item_get_hidden (XFCE_SYSTRAY_SNI_ITEM (child));
+
+  return systray_socket_get_hidden (XFCE_SYSTRAY_SOCKET (child));
+}
+
+
+
+static const gchar *
+systray_box_child_get_name (GtkWidget *child)
+{
+  if (XFCE_IS_SYSTRAY_SNI_ITEM (child))
+    return systray_sni_item_get_name (XFCE_SYSTRAY_SNI_ITEM (child));
+
+  return systray_socket_get_name (XFCE_SYSTRAY_SOCKET (child));
+}
+
+
+
 static gint
 systray_box_compare_function (gconstpointer a,
                               gconstpointer b)
@@ -694,14 +722,14 @@ systray_box_compare_function (gconstpointer a,
   gboolean     hidden_a, hidden_b;
 
   /* sort hidden icons before visible ones */
-  hidden_a = systray_socket_get_hidden (XFCE_SYSTRAY_SOCKET (a));
-  hidden_b = systray_socket_get_hidden (XFCE_SYSTRAY_SOCKET (b));
+  hidden_a = systray_box_child_get_hidden (GTK_WIDGET (a));
+  hidden_b = systray_box_child_get_hidden (GTK_WIDGET (b));
   if (hidden_a != hidden_b)
     return hidden_a ? 1 : -1;
 
   /* sort icons by name */
-  name_a = systray_socket_get_name (XFCE_SYSTRAY_SOCKET (a));
-  name_b = systray_socket_get_name (XFCE_SYSTRAY_SOCKET (b));
+  name_a = systray_box_child_get_name (GTK_WIDGET (a));
+  name_b = systray_box_child_get_name (GTK_WIDGET (b));
 
 #if GLIB_CHECK_VERSION (2, 16, 0)
   return g_strcmp0 (name_a, name_b);
@@ -0,0 +1,737 @@
+/*
+ * Copyright (C) 2026 Xfce Development Team
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include <gtk/gtk.h>
+#include <gio/gio.h>
+
+#include <libxfce4panel/libxfce4panel.h>
+
+#include <common/panel-private.h>
+#include <common/panel-debug.h>
+
+#include "systray-sni-host.h"
+#include "systray-sni-item.h"
+
+#define WATCHER_NAME       "org.kde.StatusNotifierWatcher"
+#define WATCHER_PATH       "/StatusNotifierWatcher"
+#define WATCHER_INTERFACE  "org.kde.StatusNotifierWatcher"
+#define HOST_NAME_PREFIX   "org.kde.StatusNotifierHost"
+#define INSTANCE_NAME      "org.xfce.Panel.Systray.StatusNotifierHost"
+#define ITEM_DEFAULT_PATH  "/StatusNotifierItem"
+
+
+
+static void systray_sni_host_dispose    (GObject        *object);
+static void systray_sni_host_finalize   (GObject        *object);
+static void systray_sni_host_bus_ready  (GObject        *source_object,
+                                         GAsyncResult   *res,
+                                         gpointer        user_data);
+static void systray_sni_host_stop       (SystraySniHost *host);
+
+
+
+enum
+{
+  ITEM_ADDED,
+  ITEM_REMOVED,
+  LAST_SIGNAL
+};
+
+struct _SystraySniHostClass
+{
+  GObjectClass __parent__;
+};
+
+struct _SystraySniHost
+{
+  GObject          __parent__;
+
+  GDBusConnection *connection;
+  GCancellable    *cancellable;
+
+  /* only one notification area in the session shows the items */
+  guint            instance_owner_id;
+
+  /* watcher object exported by the plugin */
+  GDBusNodeInfo   *node_info;
+  guint            object_id;
+  guint            watcher_owner_id;
+
+  /* if another watcher is running, we register as a host */
+  guint            host_owner_id;
+  guint            watcher_signal_ids[2];
+
+  /* registered items, the key is the bus name and object path */
+  GHashTable      *items;
+};
+
+typedef struct
+{
+  SystraySniHost *host;
+  gchar          *key;
+  GtkWidget      *widget;
+  guint           watch_id;
+}
+SniHostItem;
+
+
+
+static guint sni_host_signals[LAST_SIGNAL];
+
+static const gchar watcher_xml[] =
+  "<node>"
+  "  <interface name='" WATCHER_INTERFACE "'>"
+  "    <method name='RegisterStatusNotifierItem'>"
+  "      <arg type='s' name='service' direction='in'/>"
+  "    </method>"
+  "    <method name='RegisterStatusNotifierHost'>"
+  "      <arg type='s' name='service' direction='in'/>"
+  "    </method>"
+  "    <property name='RegisteredStatusNotifierItems' type='as' access='read'/>"
+  "    <property name='IsStatusNotifierHostRegistered' type='b' access='read'/>"
+  "    <property name='ProtocolVersion' type='i' access='read'/>"
+  "    <signal name='StatusNotifierItemRegistered'>"
+  "      <arg type='s' name='service'/>"
+  "    </signal>"
+  "    <signal name='StatusNotifierItemUnregistered'>"
+  "      <arg type='s' name='service'/>"
+  "    </signal>"
+  "    <signal name='StatusNotifierHostRegistered'/>"
+  "  </interface>"
+  "</node>";
+
+
+
+XFCE_PANEL_DEFINE_TYPE (SystraySniHost, systray_sni_host, G_TYPE_OBJECT)
+
+
+
+static void
+systray_sni_host_class_init (SystraySniHostClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->dispose = systray_sni_host_dispose;
+  gobject_class->finalize = systray_sni_host_finalize;
+
+  sni_host_signals[ITEM_ADDED] =
+      g_signal_new (g_intern_static_string ("item-added"),
+                    G_OBJECT_CLASS_TYPE (klass),
+                    G_SIGNAL_RUN_LAST,
+                    0, NULL, NULL,
+                    g_cclosure_marshal_VOID__OBJECT,
+                    G_TYPE_NONE, 1,
+                    GTK_TYPE_WIDGET);
+
+  sni_host_signals[ITEM_REMOVED] =
+      g_signal_new (g_intern_static_string ("item-removed"),
+                    G_OBJECT_CLASS_TYPE (klass),
+                    G_SIGNAL_RUN_LAST,
+                    0, NULL, NULL,
+                    g_cclosure_marshal_VOID__OBJECT,
+                    G_TYPE_NONE, 1,
+                    GTK_TYPE_WIDGET);
+}
+
+
+
+static void
+systray_sni_host_item_free (gpointer data)
+{
+  SniHostItem *item = data;
+
+  if (item->watch_id != 0)
+    g_bus_unwatch_name (item->watch_id);
+
+  g_object_unref (G_OBJECT (item->widget));
+  g_free (item->key);
+  g_slice_free (SniHostItem, item);
+}
+
+
+
+static void
+systray_sni_host_init (SystraySniHost *host)
+{
+  host->cancellable = g_cancellable_new ();
+  host->items = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+                                       systray_sni_host_item_free);
+
+  g_bus_get (G_BUS_TYPE_SESSION, host->cancellable,
+             systray_sni_host_bus_ready, host);
+}
+
+
+
+static void
+systray_sni_host_dispose (GObject *object)
+{
+  SystraySniHost *host = XFCE_SYSTRAY_SNI_HOST (object);
+
+  g_cancellable_cancel (host->cancellable);
+
+  if (host->instance_owner_id != 0)
+    {
+      g_bus_unown_name (host->instance_owner_id);
+      host->instance_owner_id = 0;
+    }
+
+  systray_sni_host_stop (host);
+
+  (*G_OBJECT_CLASS (systray_sni_host_parent_class)->dispose) (object);
+}
+
+
+
+static void
+systray_sni_host_finalize (GObject *object)
+{
+  SystraySniHost *host = XFCE_SYSTRAY_SNI_HOST (object);
+
+  g_hash_table_destroy (host->items);
+
+  if (host->node_info != NULL)
+    g_dbus_node_info_unref (host->node_info);
+  if (host->connection != NULL)
+    g_object_unref (G_OBJECT (host->connection));
+  g_object_unref (G_OBJECT (host->cancellable));
+
+  (*G_OBJECT_CLASS (systray_sni_host_parent_class)->finalize) (object);
+}
+
+
+
+static void
+systray_sni_host_emit_watcher_signal (SystraySniHost *host,
+                                      const gchar    *signal_name,
+                                      const gchar    *key)
+{
+  /* only emit signals if we are the watcher */
+  if (host->object_id == 0 || host->watcher_owner_id == 0)
+    return;
+
+  g_dbus_connection_emit_signal (host->connection, NULL, WATCHER_PATH,
+                                 WATCHER_INTERFACE, signal_name,
+                                 key != NULL ? g_variant_new ("(s)", key) : NULL,
+                                 NULL);
+}
+
+
+
+static void
+systray_sni_host_remove_item (SystraySniHost *host,
+                              const gchar    *key)
+{
+  SniHostItem *item;
+
+  item = g_hash_table_lookup (host->items, key);
+  if (item == NULL)
+    return;
+
+  panel_debug (PANEL_DEBUG_SYSTRAY, "status notifier item %s removed", key);
+
+  systray_sni_host_emit_watcher_signal (host, "StatusNotifierItemUnregistered", key);
+  g_signal_emit (G_OBJECT (host), sni_host_signals[ITEM_REMOVED], 0, item->widget);
+
+  g_hash_table_remove (host->items, key);
+}
+
+
+
+static void
+systray_sni_host_name_vanished (GDBusConnection *connection,
+                                const gchar     *name,
+                                gpointer         user_data)
+{
+  SniHostItem *item = user_data;
+
+  systray_sni_host_remove_item (item->host, item->key);
+}
+
+
+
+static gboolean
+systray_sni_host_add_item (SystraySniHost *host,
+                           const gchar    *bus_name,
+                           const gchar    *object_path)
+{
+  SniHostItem *item;
+  gchar       *key;
+
+  if (!g_dbus_is_name (bus_name)
+      || !g_variant_is_object_path (object_path))
+    return FALSE;
+
+  key = g_strconcat (bus_name, object_path, NULL);
+  if (g_hash_table_lookup (host->items, key) != NULL)
+    {
+      g_free (key);
+      return FALSE;
+    }
+
+  panel_debug (PANEL_DEBUG_SYSTRAY, "status notifier item %s added", key);
+
+  item = g_slice_new0 (SniHostItem);
+  item->host = host;
+  item->key = key;
+  item->widget = systray_sni_item_new (host->connection, bus_name, object_path);
+  g_object_ref_sink (G_OBJECT (item->widget));
+  g_hash_table_insert (host->items, item->key, item);
+
+  /* remove the item when the application leaves the bus */
+  item->watch_id = g_bus_watch_name_on_connection (host->connection, bus_name,
+                                                   G_BUS_NAME_WATCHER_FLAGS_NONE,
+                                                   NULL, systray_sni_host_name_vanished,
+                                                   item, NULL);
+
+  g_signal_emit (G_OBJECT (host), sni_host_signals[ITEM_ADDED], 0, item->widget);
+  systray_sni_host_emit_watcher_signal (host, "StatusNotifierItemRegistered", key);
+
+  return TRUE;
+}
+
+
+
+static void
+systray_sni_host_add_service (SystraySniHost *host,
+                              const gchar    *service)
+{
+  const gchar *path;
+  gchar       *bus_name;
+
+  /* services are registered as "bus_name/object/path" or "bus_name" */
+  path = strchr (service, '/');
+  if (path == NULL)
+    {
+      systray_sni_host_add_item (host, service, ITEM_DEFAULT_PATH);
+    }
+  else
+    {
+      bus_name = g_strndup (service, path - service);
+      systray_sni_host_add_item (host, bus_name, path);
+      g_free (bus_name);
+    }
+}
+
+
+
+static void
+systray_sni_host_method_call (GDBusConnection       *connection,
+                              const gchar           *sender,
+                              const gchar           *object_path,
+                              const gchar           *interface_name,
+                              const gchar           *method_name,
+                              GVariant              *parameters,
+                              GDBusMethodInvocation *invocation,
+                              gpointer               user_data)
+{
+  SystraySniHost *host = XFCE_SYSTRAY_SNI_HOST (user_data);
+  const gchar    *service;
+
+  g_variant_get (parameters, "(&s)", &service);
+
+  if (strcmp (method_name, "RegisterStatusNotifierItem") == 0)
+    {
+      /* applications either send their object path or their bus name */
+      if (*service == '/')
+        systray_sni_host_add_item (host, sender, service);
+      else
+        systray_sni_host_add_item (host, service, ITEM_DEFAULT_PATH);
+    }
+  else if (strcmp (method_name, "RegisterStatusNotifierHost") == 0)
+    {
+      /* the plugin is the host, other hosts are only announced */
+      systray_sni_host_emit_watcher_signal (host, "StatusNotifierHostRegistered", NULL);
+    }
+
+  g_dbus_method_invocation_return_value (invocation, NULL);
+}
+
+
+
+static GVariant *
+systray_sni_host_get_property (GDBusConnection  *connection,
+                               const gchar      *sender,
+                               const gchar      *object_path,
+                               const gchar      *interface_name,
+                               const gchar      *property_name,
+                               GError          **error,
+                               gpointer          user_data)
+{
+  SystraySniHost  *host = XFCE_SYSTRAY_SNI_HOST (user_data);
+  GVariantBuilder  builder;
+  GHashTableIter   iter;
+  gpointer         key;
+
+  if (strcmp (property_name, "RegisteredStatusNotifierItems") == 0)
+    {
+      g_variant_builder_init (&builder, G_VARIANT_TYPE ("as"));
+      g_hash_table_iter_init (&iter, host->items);
+      while (g_hash_table_iter_next (&iter, &key, NULL))
+        g_variant_builder_add (&builder, "s", key);
+
+      return g_variant_builder_end (&builder);
+    }
+  else if (strcmp (property_name, "IsStatusNotifierHostRegistered") == 0)
+    {
+      return g_variant_new_boolean (TRUE);
+    }
+  else if (strcmp (property_name, "ProtocolVersion") == 0)
+    {
+      return g_variant_new_int32 (0);
+    }
+
+  return NULL;
+}
+
+
+
+static const GDBusInterfaceVTable watcher_vtable =
+{
+  systray_sni_host_method_call,
+  systray_sni_host_get_property,
+  NULL
+};
+
+
+
+static void
+systray_sni_host_watcher_signal (GDBusConnection *connection,
+                                 const gchar     *sender_name,
+                                 const gchar     *object_path,
+                                 const gchar     *interface_name,
+                                 const gchar     *signal_name,
+                                 GVariant        *parameters,
+                                 gpointer         user_data)
+{
+  SystraySniHost *host = XFCE_SYSTRAY_SNI_HOST (user_data);
+  const gchar    *service;
+  const gchar    *path;
+  gchar          *key;
+
+  if (!g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(s)")))
+    return;
+
+  g_variant_get (parameters, "(&s)", &service);
+
+  if (strcmp (signal_name, "StatusNotifierItemRegistered") == 0)
+    {
+      systray_sni_host_add_service (host, service);
+    }
+  else
+    {
+      path = strchr (service, '/');
+      key = path != NULL ? g_strdup (service)
+                         : g_strconcat (service, ITEM_DEFAULT_PATH, NULL);
+      systray_sni_host_remove_item (host, key);
+      g_free (key);
+    }
+}
+
+
+
+static void
+systray_sni_host_items_ready (GObject      *source_object,
+                              GAsyncResult *res,
+                              gpointer      user_data)
+{
+  SystraySniHost *host;
+  GVariant       *result;
+  GVariant       *value;
+  GVariantIter    iter;
+  const gchar    *service;
+  GError         *error = NULL;
+
+  result = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object), res, &error);
+  if (result == NULL)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_message ("Failed to get the registered status notifier items: %s",
+                   error->message);
+      g_error_free (error);
+      return;
+    }
+
+  host = XFCE_SYSTRAY_SNI_HOST (user_data);
+
+  /* the host stopped while waiting for the reply */
+  if (host->host_owner_id == 0)
+    {
+      g_variant_unref (result);
+      return;
+    }
+
+  g_variant_get (result, "(v)", &value);
+  if (g_variant_is_of_type (value, G_VARIANT_TYPE_STRING_ARRAY))
+    {
+      g_variant_iter_init (&iter, value);
+      while (g_variant_iter_next (&iter, "&s", &service))
+        systray_sni_host_add_service (host, service);
+    }
+
+  g_variant_unref (value);
+  g_variant_unref (result);
+}
+
+
+
+static void
+systray_sni_host_register_host (SystraySniHost *host)
+{
+  static guint  counter = 0;
+  gchar        *name;
+
+  /* subscribe before fetching the items, so we don't miss any */
+  host->watcher_signal_ids[0] =
+      g_dbus_connection_signal_subscribe (host->connection, WATCHER_NAME,
+                                          WATCHER_INTERFACE,
+                                          "StatusNotifierItemRegistered",
+                                          WATCHER_PATH, NULL,
+                                          G_DBUS_SIGNAL_FLAGS_NONE,
+                                          systray_sni_host_watcher_signal,
+                                          host, NULL);
+  host->watcher_signal_ids[1] =
+      g_dbus_connection_signal_subscribe (host->connection, WATCHER_NAME,
+                                          WATCHER_INTERFACE,
+                                          "StatusNotifierItemUnregistered",
+                                          WATCHER_PATH, NULL,
+                                          G_DBUS_SIGNAL_FLAGS_NONE,
+                                          systray_sni_host_watcher_signal,
+                                          host, NULL);
+
+  name = g_strdup_printf (HOST_NAME_PREFIX "-%d-%u", (gint) getpid (), ++counter);
+  host->host_owner_id = g_bus_own_name_on_connection (host->connection, name,
+                                                      G_BUS_NAME_OWNER_FLAGS_NONE,
+                                                      NULL, NULL, NULL, NULL);
+
+  g_dbus_connection_call (host->connection, WATCHER_NAME, WATCHER_PATH,
+                          WATCHER_INTERFACE, "RegisterStatusNotifierHost",
+                          g_variant_new ("(s)", name), NULL,
+                          G_DBUS_CALL_FLAGS_NONE, -1,
+                          NULL, NULL, NULL);
+  g_free (name);
+
+  g_dbus_connection_call (host->connection, WATCHER_NAME, WATCHER_PATH,
+                          "org.freedesktop.DBus.Properties", "Get",
+                          g_variant_new ("(ss)", WATCHER_INTERFACE,
+                                         "RegisteredStatusNotifierItems"),
+                          G_VARIANT_TYPE ("(v)"), G_DBUS_CALL_FLAGS_NONE, -1,
+                          host->cancellable, systray_sni_host_items_ready, host);
+}
+
+
+
+static void
+systray_sni_host_name_acquired (GDBusConnection *connection,
+                                const gchar     *name,
+                                gpointer         user_data)
+{
+  SystraySniHost *host = XFCE_SYSTRAY_SNI_HOST (user_data);
+
+  panel_debug (PANEL_DEBUG_SYSTRAY, "running as status notifier watcher");
+
+  systray_sni_host_emit_watcher_signal (host, "StatusNotifierHostRegistered", NULL);
+}
+
+
+
+static void
+systray_sni_host_name_lost (GDBusConnection *connection,
+                            const gchar     *name,
+                            gpointer         user_data)
+{
+  SystraySniHost *host = XFCE_SYSTRAY_SNI_HOST (user_data);
+
+  if (connection == NULL || host->host_owner_id != 0)
+    return;
+
+  panel_debug (PANEL_DEBUG_SYSTRAY, "another status notifier watcher is "
+               "running, registering as host");
+
+  /* another watcher is running, show its items instead */
+  if (host->object_id != 0)
+    {
+      g_dbus_connection_unregister_object (host->connection, host->object_id);
+      host->object_id = 0;
+    }
+
+  g_bus_unown_name (host->watcher_owner_id);
+  host->watcher_owner_id = 0;
+
+  systray_sni_host_register_host (host);
+}
+
+
+
+static void
+systray_sni_host_start (SystraySniHost *host)
+{
+  GError *error = NULL;
+
+  host->object_id =
+      g_dbus_connection_register_object (host->connection, WATCHER_PATH,
+                                         host->node_info->interfaces[0],
+                                         &watcher_vtable, host, NULL, &error);
+  if (host->object_id == 0)
+    {
+      g_message ("Failed to export the status notifier watcher: %s", error->message);
+      g_error_free (error);
+
+      systray_sni_host_register_host (host);
+      return;
+    }
+
+  host->watcher_owner_id =
+      g_bus_own_name_on_connection (host->connection, WATCHER_NAME,
+                                    G_BUS_NAME_OWNER_FLAGS_NONE,
+                                    systray_sni_host_name_acquired,
+                                    systray_sni_host_name_lost,
+                                    host, NULL);
+}
+
+
+
+static void
+systray_sni_host_stop (SystraySniHost *host)
+{
+  GHashTableIter  iter;
+  gpointer        item;
+  guint           i;
+
+  if (host->watcher_owner_id != 0)
+    {
+      g_bus_unown_name (host->watcher_owner_id);
+      host->watcher_owner_id = 0;
+    }
+
+  if (host->host_owner_id != 0)
+    {
+      g_bus_unown_name (host->host_owner_id);
+      host->host_owner_id = 0;
+    }
+
+  if (host->object_id != 0)
+    {
+      g_dbus_connection_unregister_object (host->connection, host->object_id);
+      host->object_id = 0;
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (host->watcher_signal_ids); i++)
+    {
+      if (host->watcher_signal_ids[i] != 0)
+        {
+          g_dbus_connection_signal_unsubscribe (host->connection,
+                                                host->watcher_signal_ids[i]);
+          host->watcher_signal_ids[i] = 0;
+        }
+    }
+
+  /* remove the items from the notification area */
+  g_hash_table_iter_init (&iter, host->items);
+  while (g_hash_table_iter_next (&iter, NULL, &item))
+    {
+      g_signal_emit (G_OBJECT (host), sni_host_signals[ITEM_REMOVED], 0,
+                     ((SniHostItem *) item)->widget);
+      g_hash_table_iter_remove (&iter);
+    }
+}
+
+
+
+static void
+systray_sni_host_instance_acquired (GDBusConnection *connection,
+                                    const gchar     *name,
+                                    gpointer         user_data)
+{
+  SystraySniHost *host = XFCE_SYSTRAY_SNI_HOST (user_data);
+
+  if (host->object_id == 0 && host->host_owner_id == 0)
+    systray_sni_host_start (host);
+}
+
+
+
+static void
+systray_sni_host_instance_lost (GDBusConnection *connection,
+                                const gchar     *name,
+                                gpointer         user_data)
+{
+  SystraySniHost *host = XFCE_SYSTRAY_SNI_HOST (user_data);
+
+  panel_debug (PANEL_DEBUG_SYSTRAY, "another notification area shows the "
+               "status notifier items");
+
+  /* the name is queued, we take over when the other plugin leaves */
+  systray_sni_host_stop (host);
+}
+
+
+
+static void
+systray_sni_host_bus_ready (GObject      *source_object,
+                            GAsyncResult *res,
+                            gpointer      user_data)
+{
+  SystraySniHost  *host;
+  GDBusConnection *connection;
+  GError          *error = NULL;
+
+  connection = g_bus_get_finish (res, &error);
+  if (connection == NULL)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        g_message ("Failed to connect to the session bus: %s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  host = XFCE_SYSTRAY_SNI_HOST (user_data);
+  host->connection = connection;
+
+  host->node_info = g_dbus_node_info_new_for_xml (watcher_xml, NULL);
+  panel_assert (host->node_info != NULL);
+
+  /* a second notification area would show every item again, so only
+   * the plugin owning this name hosts the items */
+  host->instance_owner_id =
+      g_bus_own_name_on_connection (connection, INSTANCE_NAME,
+                                    G_BUS_NAME_OWNER_FLAGS_NONE,
+                                    systray_sni_host_instance_acquired,
+                                    systray_sni_host_instance_lost,
+                                    host, NULL);
+}
+
+
+
+SystraySniHost *
+systray_sni_host_new (void)
+{
+  return g_object_new (XFCE_TYPE_SYSTRAY_SNI_HOST, NULL);
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2026 Xfce Development Team
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __SYSTRAY_SNI_HOST_H__
+#define __SYSTRAY_SNI_HOST_H__
+
+#include <gtk/gtk.h>
+#include <libxfce4panel/libxfce4panel.h>
+
+typedef struct _SystraySniHostClass SystraySniHostClass;
+typedef struct _SystraySniHost      SystraySniHost;
+
+#define XFCE_TYPE_SYSTRAY_SNI_HOST            (systray_sni_host_get_type ())
+#define XFCE_SYSTRAY_SNI_HOST(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), XFCE_TYPE_SYSTRAY_SNI_HOST, SystraySniHost))
+#define XFCE_SYSTRAY_SNI_HOST_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), XFCE_TYPE_SYSTRAY_SNI_HOST, SystraySniHostClass))
+#define XFCE_IS_SYSTRAY_SNI_HOST(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), XFCE_TYPE_SYSTRAY_SNI_HOST))
+#define XFCE_IS_SYSTRAY_SNI_HOST_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), XFCE_TYPE_SYSTRAY_SNI_HOST))
+#define XFCE_SYSTRAY_SNI_HOST_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), XFCE_TYPE_SYSTRAY_SNI_HOST, SystraySniHostClass))
+
+GType           systray_sni_host_get_type      (void) G_GNUC_CONST;
+
+void            systray_sni_host_register_type (XfcePanelTypeModule *type_module);
+
+SystraySniHost *systray_sni_host_new           (void) G_GNUC_MALLOC;
+
+#endif /* !__SYSTRAY_SNI_HOST_H__ */
@@ -0,0 +1,938 @@
+/*
+ * Copyright (C) 2026 Xfce Development Team
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <gtk/gtk.h>
+#include <gio/gio.h>
+
+#include <libxfce4panel/libxfce4panel.h>
+
+#include <common/panel-private.h>
+#include <common/panel-debug.h>
+
+#include "systray-sni-item.h"
+
+#define SNI_INTERFACE      "org.kde.StatusNotifierItem"
+#define PROPERTIES_IFACE   "org.freedesktop.DBus.Properties"
+
+/* minimum size requested, the box allocates the row size */
+#define ICON_SIZE_MIN      (16)
+
+
+
+static void     systray_sni_item_dispose              (GObject          *object);
+static void     systray_sni_item_finalize             (GObject          *object);
+static void     systray_sni_item_get_preferred_width  (GtkWidget        *widget,
+                                                       gint             *minimum_width,
+                                                       gint             *natural_width);
+static void     systray_sni_item_get_preferred_height (GtkWidget        *widget,
+                                                       gint             *minimum_height,
+                                                       gint             *natural_height);
+static void     systray_sni_item_size_allocate        (GtkWidget        *widget,
+                                                       GtkAllocation    *allocation);
+static gboolean systray_sni_item_draw                 (GtkWidget        *widget,
+                                                       cairo_t          *cr);
+static void     systray_sni_item_style_updated        (GtkWidget        *widget);
+static gboolean systray_sni_item_button_release_event (GtkWidget        *widget,
+                                                       GdkEventButton   *event);
+static gboolean systray_sni_item_scroll_event         (GtkWidget        *widget,
+                                                       GdkEventScroll   *event);
+static void     systray_sni_item_fetch                (SystraySniItem   *item,
+                                                       const gchar      *property);
+
+
+
+enum
+{
+  NAME_CHANGED,
+  LAST_SIGNAL
+};
+
+/* the properties that changed in an update */
+enum
+{
+  CHANGED_NONE   = 0,
+  CHANGED_NAME   = 1 << 0,
+  CHANGED_ICON   = 1 << 1,
+  CHANGED_STATUS = 1 << 2,
+  CHANGED_TITLE  = 1 << 3
+};
+
+struct _SystraySniItemClass
+{
+  GtkEventBoxClass __parent__;
+};
+
+struct _SystraySniItem
+{
+  GtkEventBox      __parent__;
+
+  GDBusConnection *connection;
+  GCancellable    *cancellable;
+  guint            signal_id;
+
+  gchar           *bus_name;
+  gchar           *object_path;
+
+  /* lowercased id, used like the name of xembed icons */
+  gchar           *name;
+
+  gchar           *title;
+  gchar           *status;
+  gchar           *icon_name;
+  gchar           *attention_icon_name;
+  gchar           *icon_theme_path;
+  GVariant        *icon_pixmap;
+  GVariant        *attention_icon_pixmap;
+
+  /* icon theme with the search path of the item */
+  GtkIconTheme    *icon_theme;
+
+  /* rendered icon, reused until the icon or size changes */
+  cairo_surface_t *surface;
+  gint             surface_size;
+  gint             surface_scale;
+
+  /* logical size of the rendered icon, which might not be square */
+  gint             surface_width;
+  gint             surface_height;
+
+  guint            item_is_menu : 1;
+  guint            ready : 1;
+  guint            hidden : 1;
+};
+
+/* pending property call, the item is not touched after cancellation */
+typedef struct
+{
+  SystraySniItem *item;
+  const gchar    *property;
+}
+SniItemCall;
+
+
+
+static guint sni_item_signals[LAST_SIGNAL];
+
+
+
+XFCE_PANEL_DEFINE_TYPE (SystraySniItem, systray_sni_item, GTK_TYPE_EVENT_BOX)
+
+
+
+static void
+systray_sni_item_class_init (SystraySniItemClass *klass)
+{
+  GObjectClass   *gobject_class;
+  GtkWidgetClass *gtkwidget_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->dispose = systray_sni_item_dispose;
+  gobject_class->finalize = systray_sni_item_finalize;
+
+  gtkwidget_class = GTK_WIDGET_CLASS (klass);
+  gtkwidget_class->get_preferred_width = systray_sni_item_get_preferred_width;
+  gtkwidget_class->get_preferred_height = systray_sni_item_get_preferred_height;
+  gtkwidget_class->size_allocate = systray_sni_item_size_allocate;
+  gtkwidget_class->draw = systray_sni_item_draw;
+  gtkwidget_class->style_updated = systray_sni_item_style_updated;
+  gtkwidget_class->button_release_event = systray_sni_item_button_release_event;
+  gtkwidget_class->scroll_event = systray_sni_item_scroll_event;
+
+  sni_item_signals[NAME_CHANGED] =
+      g_signal_new (g_intern_static_string ("name-changed"),
+                    G_OBJECT_CLASS_TYPE (klass),
+                    G_SIGNAL_RUN_LAST,
+                    0, NULL, NULL,
+                    g_cclosure_marshal_VOID__VOID,
+                    G_TYPE_NONE, 0);
+}
+
+
+
+static void
+systray_sni_item_init (SystraySniItem *item)
+{
+  item->cancellable = g_cancellable_new ();
+  item->hidden = FALSE;
+  item->ready = FALSE;
+
+  gtk_event_box_set_visible_window (GTK_EVENT_BOX (item), FALSE);
+  gtk_widget_add_events (GTK_WIDGET (item),
+                         GDK_BUTTON_PRESS_MASK
+                         | GDK_BUTTON_RELEASE_MASK
+                         | GDK_SCROLL_MASK);
+}
+
+
+
+static void
+systray_sni_item_surface_free (SystraySniItem *item)
+{
+  if (item->surface != NULL)
+    {
+      cairo_surface_destroy (item->surface);
+      item->surface = NULL;
+    }
+}
+
+
+
+static void
+systray_sni_item_dispose (GObject *object)
+{
+  SystraySniItem *item = XFCE_SYSTRAY_SNI_ITEM (object);
+
+  /* pending calls will not touch the item anymore */
+  g_cancellable_cancel (item->cancellable);
+
+  if (item->signal_id != 0)
+    {
+      g_dbus_connection_signal_unsubscribe (item->connection, item->signal_id);
+      item->signal_id = 0;
+    }
+
+  (*G_OBJECT_CLASS (systray_sni_item_parent_class)->dispose) (object);
+}
+
+
+
+static void
+systray_sni_item_finalize (GObject *object)
+{
+  SystraySniItem *item = XFCE_SYSTRAY_SNI_ITEM (object);
+
+  systray_sni_item_surface_free (item);
+
+  if (item->icon_pixmap != NULL)
+    g_variant_unref (item->icon_pixmap);
+  if (item->attention_icon_pixmap != NULL)
+    g_variant_unref (item->attention_icon_pixmap);
+  if (item->icon_theme != NULL)
+    g_object_unref (G_OBJECT (item->icon_theme));
+
+  g_free (item->bus_name);
+  g_free (item->object_path);
+  g_free (item->name);
+  g_free (item->title);
+  g_free (item->status);
+  g_free (item->icon_name);
+  g_free (item->attention_icon_name);
+  g_free (item->icon_theme_path);
+
+  g_object_unref (G_OBJECT (item->cancellable));
+  g_object_unref (G_OBJECT (item->connection));
+
+  (*G_OBJECT_CLASS (systray_sni_item_parent_class)->finalize) (object);
+}
+
+
+
+static void
+systray_sni_item_get_preferred_width (GtkWidget *widget,
+                                      gint      *minimum_width,
+                                      gint      *natural_width)
+{
+  if (minimum_width != NULL)
+    *minimum_width = ICON_SIZE_MIN;
+  if (natural_width != NULL)
+    *natural_width = ICON_SIZE_MIN;
+}
+
+
+
+static void
+systray_sni_item_get_preferred_height (GtkWidget *widget,
+                                       gint      *minimum_height,
+                                       gint      *natural_height)
+{
+  if (minimum_height != NULL)
+    *minimum_height = ICON_SIZE_MIN;
+  if (natural_height != NULL)
+    *natural_height = ICON_SIZE_MIN;
+}
+
+
+
+static void
+systray_sni_item_size_allocate (GtkWidget     *widget,
+                                GtkAllocation *allocation)
+{
+  SystraySniItem *item = XFCE_SYSTRAY_SNI_ITEM (widget);
+
+  (*GTK_WIDGET_CLASS (systray_sni_item_parent_class)->size_allocate) (widget, allocation);
+
+  /* the surface is rendered again if the size changed */
+  if (item->surface != NULL
+      && item->surface_size != MIN (allocation->width, allocation->height))
+    systray_sni_item_surface_free (item);
+}
+
+
+
+static GdkPixbuf *
+systray_sni_item_pixmap_to_pixbuf (GVariant *pixmaps,
+                                   gint      size)
+{
+  GVariantIter  iter;
+  GVariant     *pixmap, *best = NULL;
+  gint          width, height;
+  gint          best_width = 0, best_height = 0;
+  const guchar *data;
+  gsize         n_bytes;
+  guchar       *pixels, *p;
+  gsize         i;
+  GdkPixbuf    *pixbuf, *scaled;
+  gint          dest_width, dest_height;
+
+  if (pixmaps == NULL)
+    return NULL;
+
+  /* pick the smallest pixmap that is at least the requested size,
+   * or the largest one if they are all smaller */
+  g_variant_iter_init (&iter, pixmaps);
+  while ((pixmap = g_variant_iter_next_value (&iter)) != NULL)
+    {
+      g_variant_get_child (pixmap, 0, "i", &width);
+      g_variant_get_child (pixmap, 1, "i", &height);
+
+      if (width > 0 && height > 0
+          && (best == NULL
+              || (best_width < size && width > best_width)
+              || (width >= size && width < best_width)))
+        {
+          if (best != NULL)
+            g_variant_unref (best);
+          best = g_variant_ref (pixmap);
+          best_width = width;
+          best_height = height;
+        }
+
+      g_variant_unref (pixmap);
+    }
+
+  if (best == NULL)
+    return NULL;
+
+  pixmap = g_variant_get_child_value (best, 2);
+  data = g_variant_get_fixed_array (pixmap, &n_bytes, sizeof (guchar));
+  if (n_bytes != (gsize) best_width * best_height * 4)
+    {
+      g_variant_unref (pixmap);
+      g_variant_unref (best);
+      return NULL;
+    }
+
+  /* convert the ARGB32 data in network byte order to RGBA */
+  pixels = g_malloc (n_bytes);
+  for (i = 0, p = pixels; i < n_bytes; i += 4, p += 4)
+    {
+      p[0] = data[i + 1];
+      p[1] = data[i + 2];
+      p[2] = data[i + 3];
+      p[3] = data[i];
+    }
+
+  g_variant_unref (pixmap);
+  g_variant_unref (best);
+
+  pixbuf = gdk_pixbuf_new_from_data (pixels, GDK_COLORSPACE_RGB, TRUE, 8,
+                                     best_width, best_height, best_width * 4,
+                                     (GdkPixbufDestroyNotify) g_free, NULL);
+
+  /* fit the pixmap in the icon size, keeping its aspect ratio */
+  if (best_width >= best_height)
+    {
+      dest_width = size;
+      dest_height = MAX (1, best_height * size / best_width);
+    }
+  else
+    {
+      dest_width = MAX (1, best_width * size / best_height);
+      dest_height = size;
+    }
+
+  if (best_width != dest_width || best_height != dest_height)
+    {
+      scaled = gdk_pixbuf_scale_simple (pixbuf, dest_width, dest_height,
+                                        GDK_INTERP_BILINEAR);
+      g_object_unref (G_OBJECT (pixbuf));
+      pixbuf = scaled;
+    }
+
+  return pixbuf;
+}
+
+
+
+static void
+systray_sni_item_render (SystraySniItem *item,
+                         gint            size,
+                         gint            scale)
+{
+  GtkWidget    *widget = GTK_WIDGET (item);
+  const gchar  *icon_name;
+  GVariant     *icon_pixmap;
+  GtkIconTheme *icon_theme;
+  GdkPixbuf    *pixbuf = NULL;
+
+  systray_sni_item_surface_free (item);
+
+  item->surface_size = size;
+  item->surface_scale = scale;
+  item->surface_width = size;
+  item->surface_height = size;
+
+  if (g_strcmp0 (item->status, "NeedsAttention") == 0
+      && (!panel_str_is_empty (item->attention_icon_name)
+          || item->attention_icon_pixmap != NULL))
+    {
+      icon_name = item->attention_icon_name;
+      icon_pixmap = item->attention_icon_pixmap;
+    }
+  else
+    {
+      icon_name = item->icon_name;
+      icon_pixmap = item->icon_pixmap;
+    }
+
+  if (!panel_str_is_empty (icon_name))
+    {
+      if (g_path_is_absolute (icon_name))
+        {
+          pixbuf = gdk_pixbuf_new_from_file_at_size (icon_name, size * scale,
+                                                     size * scale, NULL);
+        }
+      else
+        {
+          icon_theme = item->icon_theme;
+          if (icon_theme == NULL)
+            icon_theme = gtk_icon_theme_get_for_screen (gtk_widget_get_screen (widget));
+
+          item->surface = gtk_icon_theme_load_surface (icon_theme, icon_name,
+                                                       size, scale,
+                                                       gtk_widget_get_window (widget),
+                                                       GTK_ICON_LOOKUP_FORCE_SIZE,
+                                                       NULL);
+        }
+    }
+
+  /* fall back to the pixmap data sent by the item */
+  if (item->surface == NULL && pixbuf == NULL)
+    pixbuf = systray_sni_item_pixmap_to_pixbuf (icon_pixmap, size * scale);
+
+  if (pixbuf != NULL)
+    {
+      item->surface_width = gdk_pixbuf_get_width (pixbuf) / scale;
+      item->surface_height = gdk_pixbuf_get_height (pixbuf) / scale;
+      item->surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, scale,
+                                                            gtk_widget_get_window (widget));
+      g_object_unref (G_OBJECT (pixbuf));
+    }
+}
+
+
+
+static gboolean
+systray_sni_item_draw (GtkWidget *widget,
+                       cairo_t   *cr)
+{
+  SystraySniItem *item = XFCE_SYSTRAY_SNI_ITEM (widget);
+  GtkAllocation   allocation;
+  gint            size, scale;
+
+  gtk_widget_get_allocation (widget, &allocation);
+  size = MIN (allocation.width, allocation.height);
+  scale = gtk_widget_get_scale_factor (widget);
+  if (size < 1)
+    return FALSE;
+
+  /* only render the icon if it changed, otherwise blit the cache */
+  if (item->surface == NULL
+      || item->surface_size != size
+      || item->surface_scale != scale)
+    systray_sni_item_render (item, size, scale);
+
+  if (item->surface != NULL)
+    {
+      cairo_set_source_surface (cr, item->surface,
+                                (allocation.width - item->surface_width) / 2,
+                                (allocation.height - item->surface_height) / 2);
+      cairo_paint (cr);
+    }
+
+  return FALSE;
+}
+
+
+
+static void
+systray_sni_item_style_updated (GtkWidget *widget)
+{
+  SystraySniItem *item = XFCE_SYSTRAY_SNI_ITEM (widget);
+
+  (*GTK_WIDGET_CLASS (systray_sni_item_parent_class)->style_updated) (widget);
+
+  /* the icon theme might have changed */
+  systray_sni_item_surface_free (item);
+  gtk_widget_queue_draw (widget);
+}
+
+
+
+static void
+systray_sni_item_call (SystraySniItem *item,
+                       const gchar    *method,
+                       GVariant       *parameters)
+{
+  g_dbus_connection_call (item->connection, item->bus_name, item->object_path,
+                          SNI_INTERFACE, method, parameters, NULL,
+                          G_DBUS_CALL_FLAGS_NONE, -1, NULL, NULL, NULL);
+}
+
+
+
+static gboolean
+systray_sni_item_button_release_event (GtkWidget      *widget,
+                                       GdkEventButton *event)
+{
+  SystraySniItem *item = XFCE_SYSTRAY_SNI_ITEM (widget);
+  gint            x = event->x_root;
+  gint            y = event->y_root;
+
+  if (event->button == 1 && !item->item_is_menu)
+    systray_sni_item_call (item, "Activate", g_variant_new ("(ii)", x, y));
+  else if (event->button == 2)
+    systray_sni_item_call (item, "SecondaryActivate", g_variant_new ("(ii)", x, y));
+  else if (event->button == 1 || event->button == 3)
+    systray_sni_item_call (item, "ContextMenu", g_variant_new ("(ii)", x, y));
+  else
+    return FALSE;
+
+  return TRUE;
+}
+
+
+
+static gboolean
+systray_sni_item_scroll_event (GtkWidget      *widget,
+                               GdkEventScroll *event)
+{
+  SystraySniItem *item = XFCE_SYSTRAY_SNI_ITEM (widget);
+
+  switch (event->direction)
+    {
+    case GDK_SCROLL_UP:
+      systray_sni_item_call (item, "Scroll", g_variant_new ("(is)", -1, "vertical"));
+      break;
+
+    case GDK_SCROLL_DOWN:
+      systray_sni_item_call (item, "Scroll", g_variant_new ("(is)", 1, "vertical"));
+      break;
+
+    case GDK_SCROLL_LEFT:
+      systray_sni_item_call (item, "Scroll", g_variant_new ("(is)", -1, "horizontal"));
+      break;
+
+    case GDK_SCROLL_RIGHT:
+      systray_sni_item_call (item, "Scroll", g_variant_new ("(is)", 1, "horizontal"));
+      break;
+
+    default:
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+
+
+static gboolean
+systray_sni_item_set_string (gchar    **str,
+                             GVariant  *value)
+{
+  const gchar *new_str = NULL;
+
+  if (value != NULL
+      && (g_variant_is_of_type (value, G_VARIANT_TYPE_STRING)
+          || g_variant_is_of_type (value, G_VARIANT_TYPE_OBJECT_PATH)))
+    new_str = g_variant_get_string (value, NULL);
+
+  if (g_strcmp0 (*str, new_str) == 0)
+    return FALSE;
+
+  g_free (*str);
+  *str = g_strdup (new_str);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+systray_sni_item_set_pixmap (GVariant **pixmap,
+                             GVariant  *value)
+{
+  if (value != NULL
+      && !g_variant_is_of_type (value, G_VARIANT_TYPE ("a(iiay)")))
+    value = NULL;
+
+  if (*pixmap == NULL && value == NULL)
+    return FALSE;
+
+  if (*pixmap != NULL && value != NULL
+      && g_variant_equal (*pixmap, value))
+    return FALSE;
+
+  if (*pixmap != NULL)
+    g_variant_unref (*pixmap);
+  *pixmap = value != NULL ? g_variant_ref (value) : NULL;
+
+  return TRUE;
+}
+
+
+
+static guint
+systray_sni_item_set_value (SystraySniItem *item,
+                            const gchar    *property,
+                            GVariant       *value)
+{
+  gchar *name;
+
+  if (strcmp (property, "Id") == 0)
+    {
+      if (value == NULL
+          || !g_variant_is_of_type (value, G_VARIANT_TYPE_STRING))
+        return CHANGED_NONE;
+
+      name = g_utf8_strdown (g_variant_get_string (value, NULL), -1);
+      if (g_strcmp0 (name, item->name) == 0)
+        {
+          g_free (name);
+          return CHANGED_NONE;
+        }
+
+      g_free (item->name);
+      item->name = name;
+
+      return CHANGED_NAME;
+    }
+  else if (strcmp (property, "Title") == 0)
+    {
+      if (systray_sni_item_set_string (&item->title, value))
+        return CHANGED_TITLE;
+    }
+  else if (strcmp (property, "Status") == 0)
+    {
+      if (systray_sni_item_set_string (&item->status, value))
+        return CHANGED_STATUS | CHANGED_ICON;
+    }
+  else if (strcmp (property, "IconName") == 0)
+    {
+      if (systray_sni_item_set_string (&item->icon_name, value))
+        return CHANGED_ICON;
+    }
+  else if (strcmp (property, "AttentionIconName") == 0)
+    {
+      if (systray_sni_item_set_string (&item->attention_icon_name, value))
+        return CHANGED_ICON;
+    }
+  else if (strcmp (property, "IconPixmap") == 0)
+    {
+      if (systray_sni_item_set_pixmap (&item->icon_pixmap, value))
+        return CHANGED_ICON;
+    }
+  else if (strcmp (property, "AttentionIconPixmap") == 0)
+    {
+      if (systray_sni_item_set_pixmap (&item->attention_icon_pixmap, value))
+        return CHANGED_ICON;
+    }
+  else if (strcmp (property, "IconThemePath") == 0)
+    {
+      if (systray_sni_item_set_string (&item->icon_theme_path, value))
+        {
+          if (item->icon_theme != NULL)
+            g_object_unref (G_OBJECT (item->icon_theme));
+          item->icon_theme = NULL;
+
+          /* lookup icons in the path of the application first */
+          if (!panel_str_is_empty (item->icon_theme_path))
+            {
+              item->icon_theme = gtk_icon_theme_new ();
+              gtk_icon_theme_set_screen (item->icon_theme,
+                  gtk_widget_get_screen (GTK_WIDGET (item)));
+              gtk_icon_theme_prepend_search_path (item->icon_theme,
+                                                  item->icon_theme_path);
+            }
+
+          return CHANGED_ICON;
+        }
+    }
+  else if (strcmp (property, "ItemIsMenu") == 0)
+    {
+      if (value != NULL
+          && g_variant_is_of_type (value, G_VARIANT_TYPE_BOOLEAN))
+        item->item_is_menu = g_variant_get_boolean (value);
+    }
+
+  return CHANGED_NONE;
+}
+
+
+
+static void
+systray_sni_item_apply (SystraySniItem *item,
+                        guint           changed)
+{
+  GtkWidget *widget = GTK_WIDGET (item);
+
+  if ((changed & CHANGED_ICON) != 0)
+    {
+      /* render the new icon on the next draw */
+      systray_sni_item_surface_free (item);
+      gtk_widget_queue_draw (widget);
+    }
+
+  if ((changed & CHANGED_TITLE) != 0)
+    gtk_widget_set_tooltip_text (widget, item->title);
+
+  if ((changed & CHANGED_STATUS) != 0 || !item->ready)
+    {
+      /* passive items are not shown in the tray */
+      gtk_widget_set_visible (widget, g_strcmp0 (item->status, "Passive") != 0);
+    }
+
+  item->ready = TRUE;
+
+  if ((changed & CHANGED_NAME) != 0)
+    g_signal_emit (G_OBJECT (item), sni_item_signals[NAME_CHANGED], 0);
+}
+
+
+
+static void
+systray_sni_item_get_all_ready (GObject      *source_object,
+                                GAsyncResult *res,
+                                gpointer      user_data)
+{
+  SystraySniItem *item;
+  GVariant       *result;
+  GVariantIter   *iter;
+  const gchar    *property;
+  GVariant       *value;
+  GError         *error = NULL;
+  guint           changed = CHANGED_NONE;
+
+  result = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object), res, &error);
+  if (result == NULL)
+    {
+      /* the item is gone if the call was cancelled */
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        {
+          item = XFCE_SYSTRAY_SNI_ITEM (user_data);
+          panel_debug (PANEL_DEBUG_SYSTRAY, "failed to get the properties of %s%s: %s",
+                       item->bus_name, item->object_path, error->message);
+        }
+
+      g_error_free (error);
+      return;
+    }
+
+  item = XFCE_SYSTRAY_SNI_ITEM (user_data);
+
+  g_variant_get (result, "(a{sv})", &iter);
+  while (g_variant_iter_loop (iter, "{&sv}", &property, &value))
+    changed |= systray_sni_item_set_value (item, property, value);
+  g_variant_iter_free (iter);
+  g_variant_unref (result);
+
+  systray_sni_item_apply (item, changed);
+}
+
+
+
+static void
+systray_sni_item_get_ready (GObject      *source_object,
+                            GAsyncResult *res,
+                            gpointer      user_data)
+{
+  SniItemCall *call = user_data;
+  GVariant    *result;
+  GVariant    *value;
+  GError      *error = NULL;
+
+  result = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object), res, &error);
+  if (result != NULL)
+    {
+      g_variant_get (result, "(v)", &value);
+      systray_sni_item_apply (call->item,
+          systray_sni_item_set_value (call->item, call->property, value));
+      g_variant_unref (value);
+      g_variant_unref (result);
+    }
+  else if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    {
+      /* the property is not set by the item */
+      systray_sni_item_apply (call->item,
+          systray_sni_item_set_value (call->item, call->property, NULL));
+    }
+
+  if (error != NULL)
+    g_error_free (error);
+
+  g_slice_free (SniItemCall, call);
+}
+
+
+
+static void
+systray_sni_item_fetch (SystraySniItem *item,
+                        const gchar    *property)
+{
+  SniItemCall *call;
+
+  call = g_slice_new (SniItemCall);
+  call->item = item;
+  call->property = property;
+
+  g_dbus_connection_call (item->connection, item->bus_name, item->object_path,
+                          PROPERTIES_IFACE, "Get",
+                          g_variant_new ("(ss)", SNI_INTERFACE, property),
+                          G_VARIANT_TYPE ("(v)"), G_DBUS_CALL_FLAGS_NONE, -1,
+                          item->cancellable, systray_sni_item_get_ready, call);
+}
+
+
+
+static void
+systray_sni_item_signal (GDBusConnection *connection,
+                         const gchar     *sender_name,
+                         const gchar     *object_path,
+                         const gchar     *interface_name,
+                         const gchar     *signal_name,
+                         GVariant        *parameters,
+                         gpointer         user_data)
+{
+  SystraySniItem *item = XFCE_SYSTRAY_SNI_ITEM (user_data);
+  GVariant       *value;
+  guint           changed;
+
+  /* only fetch the properties that belong to the signal */
+  if (strcmp (signal_name, "NewIcon") == 0)
+    {
+      systray_sni_item_fetch (item, "IconName");
+      systray_sni_item_fetch (item, "IconPixmap");
+    }
+  else if (strcmp (signal_name, "NewAttentionIcon") == 0)
+    {
+      systray_sni_item_fetch (item, "AttentionIconName");
+      systray_sni_item_fetch (item, "AttentionIconPixmap");
+    }
+  else if (strcmp (signal_name, "NewTitle") == 0)
+    {
+      systray_sni_item_fetch (item, "Title");
+    }
+  else if (strcmp (signal_name, "NewStatus") == 0
+           || strcmp (signal_name, "NewIconThemePath") == 0)
+    {
+      /* the new value is sent with the signal */
+      if (g_variant_is_of_type (parameters, G_VARIANT_TYPE ("(s)")))
+        {
+          value = g_variant_get_child_value (parameters, 0);
+          changed = systray_sni_item_set_value (item,
+              strcmp (signal_name, "NewStatus") == 0 ? "Status" : "IconThemePath",
+              value);
+          g_variant_unref (value);
+
+          systray_sni_item_apply (item, changed);
+        }
+    }
+}
+
+
+
+GtkWidget *
+systray_sni_item_new (GDBusConnection *connection,
+                      const gchar     *bus_name,
+                      const gchar     *object_path)
+{
+  SystraySniItem *item;
+
+  panel_return_val_if_fail (G_IS_DBUS_CONNECTION (connection), NULL);
+  panel_return_val_if_fail (g_dbus_is_name (bus_name), NULL);
+  panel_return_val_if_fail (g_variant_is_object_path (object_path), NULL);
+
+  item = g_object_new (XFCE_TYPE_SYSTRAY_SNI_ITEM, NULL);
+  item->connection = g_object_ref (G_OBJECT (connection));
+  item->bus_name = g_strdup (bus_name);
+  item->object_path = g_strdup (object_path);
+
+  item->signal_id =
+      g_dbus_connection_signal_subscribe (connection, bus_name, SNI_INTERFACE,
+                                          NULL, object_path, NULL,
+                                          G_DBUS_SIGNAL_FLAGS_NONE,
+                                          systray_sni_item_signal, item, NULL);
+
+  /* fetch all the properties once, later changes are incremental */
+  g_dbus_connection_call (connection, bus_name, object_path,
+                          PROPERTIES_IFACE, "GetAll",
+                          g_variant_new ("(s)", SNI_INTERFACE),
+                          G_VARIANT_TYPE ("(a{sv})"), G_DBUS_CALL_FLAGS_NONE, -1,
+                          item->cancellable, systray_sni_item_get_all_ready, item);
+
+  return GTK_WIDGET (item);
+}
+
+
+
+const gchar *
+systray_sni_item_get_name (SystraySniItem *item)
+{
+  panel_return_val_if_fail (XFCE_IS_SYSTRAY_SNI_ITEM (item), NULL);
+
+  return item->name;
+}
+
+
+
+gboolean
+systray_sni_item_get_hidden (SystraySniItem *item)
+{
+  panel_return_val_if_fail (XFCE_IS_SYSTRAY_SNI_ITEM (item), FALSE);
+
+  return item->hidden;
+}
+
+
+
+void
+systray_sni_item_set_hidden (SystraySniItem *item,
+                             gboolean        hidden)
+{
+  panel_return_if_fail (XFCE_IS_SYSTRAY_SNI_ITEM (item));
+
+  item->hidden = hidden;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2026 Xfce Development Team
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __SYSTRAY_SNI_ITEM_H__
+#define __SYSTRAY_SNI_ITEM_H__
+
+#include <gtk/gtk.h>
+#include <gio/gio.h>
+#include <libxfce4panel/libxfce4panel.h>
+
+typedef struct _SystraySniItemClass SystraySniItemClass;
+typedef struct _SystraySniItem      SystraySniItem;
+
+#define XFCE_TYPE_SYSTRAY_SNI_ITEM            (systray_sni_item_get_type ())
+#define XFCE_SYSTRAY_SNI_ITEM(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), XFCE_TYPE_SYSTRAY_SNI_ITEM, SystraySniItem))
+#define XFCE_SYSTRAY_SNI_ITEM_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), XFCE_TYPE_SYSTRAY_SNI_ITEM, SystraySniItemClass))
+#define XFCE_IS_SYSTRAY_SNI_ITEM(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), XFCE_TYPE_SYSTRAY_SNI_ITEM))
+#define XFCE_IS_SYSTRAY_SNI_ITEM_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), XFCE_TYPE_SYSTRAY_SNI_ITEM))
+#define XFCE_SYSTRAY_SNI_ITEM_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), XFCE_TYPE_SYSTRAY_SNI_ITEM, SystraySniItemClass))
+
+GType        systray_sni_item_get_type      (void) G_GNUC_CONST;
+
+void         systray_sni_item_register_type (XfcePanelTypeModule *type_module);
+
+GtkWidget   *systray_sni_item_new           (GDBusConnection     *connection,
+                                             const gchar         *bus_name,
+                                             const gchar         *object_path) G_GNUC_MALLOC;
+
+const gchar *systray_sni_item_get_name      (SystraySniItem      *item);
+
+gboolean     systray_sni_item_get_hidden    (SystraySniItem      *item);
+
+void         systray_sni_item_set_hidden    (SystraySniItem      *item,
+                                             gboolean             hidden);
+
+#endif /* !__SYSTRAY_SNI_ITEM_H__ */
@@ -23,12 +23,16 @@
 #include <config.h>
 #endif
 
+#ifdef HAVE_STDLIB_H
+#include <stdlib.h>
+#endif
 #ifdef HAVE_STRING_H
 #include <string.h>
 #endif
 
 #include <X11/Xlib.h>
-#include <X11/Xatom.h>
+#include <X11/Xlib-xcb.h>
+#include <xcb/xcb.h>
 
 #include <gdk/gdk.h>
 #include <gdk/gdkx.h>
@@ -43,6 +47,17 @@
 
 
 
+/* maximum length of the name properties, in 32-bit units */
+#define NAME_MAX_LENGTH (64)
+
+
+
+enum
+{
+  NAME_CHANGED,
+  LAST_SIGNAL
+};
+
 struct _SystraySocketClass
 {
   GtkSocketClass __parent__;
@@ -55,8 +70,16 @@ struct _SystraySocket
   /* plug window */
   Window           window;
 
+  /* foreign window we filter property changes on */
+  GdkWindow       *plug_window;
+
   gchar           *name;
 
+  /* requests for the name properties, collected on lookup */
+  xcb_get_property_cookie_t name_cookies[2];
+
+  guint            name_valid : 1;
+  guint            name_pending : 1;
   guint            is_composited : 1;
   guint            parent_relative_bg : 1;
   guint            hidden : 1;
@@ -72,6 +95,15 @@ static gboolean systray_socket_draw          (GtkWidget      *widget,
                                               cairo_t        *cr);
 static void     systray_socket_style_set     (GtkWidget      *widget,
                                               GtkStyle       *previous_style);
+static void     systray_socket_plug_added    (GtkSocket      *gtk_socket);
+static gboolean systray_socket_plug_removed  (GtkSocket      *gtk_socket);
+static void     systray_socket_filter_remove (SystraySocket  *socket);
+static void     systray_socket_name_request  (SystraySocket  *socket);
+static void     systray_socket_name_discard  (SystraySocket  *socket);
+
+
+
+static guint socket_signals[LAST_SIGNAL];
 
 
 
@@ -84,6 +116,7 @@ systray_socket_class_init (SystraySocketClass *klass)
 {
   GtkWidgetClass *gtkwidget_class;
   GObjectClass   *gobject_class;
+  GtkSocketClass *gtksocket_class;
 
   gobject_class = G_OBJECT_CLASS (klass);
   gobject_class->finalize = systray_socket_finalize;
@@ -93,6 +126,18 @@ systray_socket_class_init (SystraySocketClass *klass)
   gtkwidget_class->size_allocate = systray_socket_size_allocate;
   gtkwidget_class->draw = systray_socket_draw;
   gtkwidget_class->style_set = systray_socket_style_set;
+
+  gtksocket_class = GTK_SOCKET_CLASS (klass);
+  gtksocket_class->plug_added = systray_socket_plug_added;
+  gtksocket_class->plug_removed = systray_socket_plug_removed;
+
+  socket_signals[NAME_CHANGED] =
+      g_signal_new (g_intern_static_string ("name-changed"),
+                    G_OBJECT_CLASS_TYPE (klass),
+                    G_SIGNAL_RUN_LAST,
+                    0, NULL, NULL,
+                    g_cclosure_marshal_VOID__VOID,
+                    G_TYPE_NONE, 0);
 }
 
 
@@ -102,6 +147,9 @@ systray_socket_init (SystraySocket *socket)
 {
   socket->hidden = FALSE;
   socket->name = NULL;
+  socket->name_valid = FALSE;
+  socket->name_pending = FALSE;
+  socket->plug_window = NULL;
 }
 
 
@@ -111,6 +159,9 @@ systray_socket_finalize (GObject *object)
 {
   SystraySocket *socket = XFCE_SYSTRAY_SOCKET (object);
 
+  systray_socket_filter_remove (socket);
+
+  systray_socket_name_discard (socket);
   g_free (socket->name);
 
   G_OBJECT_CLASS (systray_socket_parent_class)->finalize (object);
@@ -236,39 +287,138 @@ systray_socket_style_set (GtkWidget *widget,
 
 
 
+static GdkFilterReturn
+systray_socket_filter (GdkXEvent *gdk_xevent,
+                       GdkEvent  *event,
+                       gpointer   user_data)
+{
+  SystraySocket *socket = XFCE_SYSTRAY_SOCKET (user_data);
+  XEvent        *xevent = (XEvent *) gdk_xevent;
+  GdkDisplay    *display;
+
+  if (xevent->type == PropertyNotify
+      && xevent->xproperty.window == socket->window)
+    {
+      display = gtk_widget_get_display (GTK_WIDGET (socket));
+
+      /* only refetch the name when one of the name properties changed,
+       * the new value is requested here and its reply is collected on
+       * the next lookup */
+      if (xevent->xproperty.atom == gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_NAME")
+          || xevent->xproperty.atom == gdk_x11_get_xatom_by_name_for_display (display, "WM_NAME"))
+        {
+          g_free (socket->name);
+          socket->name = NULL;
+          socket->name_valid = FALSE;
+
+          systray_socket_name_request (socket);
+
+          g_signal_emit (G_OBJECT (socket), socket_signals[NAME_CHANGED], 0);
+        }
+    }
+
+  return GDK_FILTER_CONTINUE;
+}
+
+
+
+static void
+systray_socket_filter_remove (SystraySocket *socket)
+{
+  if (socket->plug_window != NULL)
+    {
+      gdk_window_remove_filter (socket->plug_window, systray_socket_filter, socket);
+      g_object_unref (G_OBJECT (socket->plug_window));
+      socket->plug_window = NULL;
+    }
+}
+
+
+
+static void
+systray_socket_plug_added (GtkSocket *gtk_socket)
+{
+  SystraySocket *socket = XFCE_SYSTRAY_SOCKET (gtk_socket);
+  GdkWindow     *plug_window;
+
+  if (GTK_SOCKET_CLASS (systray_socket_parent_class)->plug_added != NULL)
+    (*GTK_SOCKET_CLASS (systray_socket_parent_class)->plug_added) (gtk_socket);
+
+  plug_window = gtk_socket_get_plug_window (gtk_socket);
+  if (G_UNLIKELY (plug_window == NULL || plug_window == socket->plug_window))
+    return;
+
+  systray_socket_filter_remove (socket);
+
+  /* the socket already selects property changes on the plug window,
+   * watch them to keep the cached name up-to-date */
+  socket->plug_window = g_object_ref (G_OBJECT (plug_window));
+  gdk_window_set_events (plug_window,
+      gdk_window_get_events (plug_window) | GDK_PROPERTY_CHANGE_MASK);
+  gdk_window_add_filter (plug_window, systray_socket_filter, socket);
+}
+
+
+
+static gboolean
+systray_socket_plug_removed (GtkSocket *gtk_socket)
+{
+  systray_socket_filter_remove (XFCE_SYSTRAY_SOCKET (gtk_socket));
+
+  if (GTK_SOCKET_CLASS (systray_socket_parent_class)->plug_removed != NULL)
+    return (*GTK_SOCKET_CLASS (systray_socket_parent_class)->plug_removed) (gtk_socket);
+
+  return FALSE;
+}
+
+
+
 GtkWidget *
 systray_socket_new (GdkScreen       *screen,
                     Window           window)
 {
-  SystraySocket     *socket;
-  GdkDisplay        *display;
-  XWindowAttributes  attr;
-  gint               result;
-  GdkVisual         *visual;
-  gint               red_prec, green_prec, blue_prec;
+  SystraySocket                      *socket;
+  xcb_connection_t                   *connection;
+  xcb_get_window_attributes_cookie_t  cookie;
+  xcb_get_window_attributes_reply_t  *attr;
+  xcb_generic_error_t                *error = NULL;
+  GdkVisual                          *visual;
+  gint                                red_prec, green_prec, blue_prec;
 
   panel_return_val_if_fail (GDK_IS_SCREEN (screen), NULL);
 
-  /* get the window attributes */
-  display = gdk_screen_get_display (screen);
-  gdk_error_trap_push ();
-  result = XGetWindowAttributes (GDK_DISPLAY_XDISPLAY (display),
-                                 window, &attr);
+  socket = g_object_new (XFCE_TYPE_SYSTRAY_SOCKET, NULL);
+  socket->window = window;
+  socket->is_composited = FALSE;
 
-  /* leave on an error or if the window does not exist */
-  if (gdk_error_trap_pop () != 0 || result == 0)
-    return NULL;
+  /* send the requests for the window attributes and the name together,
+   * so docking an icon waits for a single round-trip; errors are
+   * returned with the replies and never reach the xlib error handler */
+  connection = XGetXCBConnection (GDK_DISPLAY_XDISPLAY (gdk_screen_get_display (screen)));
+  cookie = xcb_get_window_attributes (connection, window);
+  systray_socket_name_request (socket);
+
+  /* leave if the window does not exist */
+  attr = xcb_get_window_attributes_reply (connection, cookie, &error);
+  free (error);
+  if (attr == NULL)
+    {
+      g_object_ref_sink (G_OBJECT (socket));
+      g_object_unref (G_OBJECT (socket));
+      return NULL;
+    }
 
   /* get the windows visual */
-  visual = gdk_x11_screen_lookup_visual (screen, attr.visual->visualid);
+  visual = gdk_x11_screen_lookup_visual (screen, attr->visual);
+  free (attr);
   panel_return_val_if_fail (visual == NULL || GDK_IS_VISUAL (visual), NULL);
   if (G_UNLIKELY (visual == NULL))
-    return NULL;
+    {
+      g_object_ref_sink (G_OBJECT (socket));
+      g_object_unref (G_OBJECT (socket));
+      return NULL;
+    }
 
-  /* create a new socket */
-  socket = g_object_new (XFCE_TYPE_SYSTRAY_SOCKET, NULL);
-  socket->window = window;
-  socket->is_composited = FALSE;
   gtk_widget_set_visual (GTK_WIDGET (socket), visual);
 
   /* check if there is an alpha channel in the visual */
@@ -308,15 +458,13 @@ systray_socket_force_redraw (SystraySocket *socket)
       xev.xexpose.height = allocation.height;
       xev.xexpose.count = 0;
 
+      /* errors are ignored asynchronously, so there is no need
+       * to sync with the server on every redraw */
       gdk_error_trap_push ();
       XSendEvent (GDK_DISPLAY_XDISPLAY (display),
                   xev.xexpose.window,
                   False, ExposureMask,
                   &xev);
-      /* We have to sync to reliably catch errors from the XSendEvent(),
-       * since that is asynchronous.
-       */
-      XSync (GDK_DISPLAY_XDISPLAY (display), False);
       gdk_error_trap_pop_ignored ();
     }
 }
@@ -334,56 +482,75 @@ systray_socket_is_composited (SystraySocket *socket)
 
 
 static gchar *
-systray_socket_get_name_prop (SystraySocket *socket,
-                              const gchar   *prop_name,
-                              const gchar   *type_name)
+systray_socket_get_name_prop (xcb_get_property_reply_t *reply,
+                              xcb_atom_t                req_type)
 {
-  GdkDisplay *display;
-  Atom        req_type, type;
-  gint        result;
-  gchar      *val;
-  gint        format;
-  gulong      nitems;
-  gulong      bytes_after;
-  gchar      *name = NULL;
+  const gchar *val;
+  gint         nitems;
+  gchar       *name = NULL;
+  const gchar *end;
+
+  /* check if everything went fine */
+  if (reply == NULL)
+    return NULL;
+
+  /* check the returned data */
+  val = xcb_get_property_value (reply);
+  nitems = xcb_get_property_value_length (reply);
+  if (reply->type == req_type
+      && reply->format == 8
+      && nitems > 0)
+   {
+     /* a truncated name can end halfway a character */
+     if (g_utf8_validate (val, nitems, &end))
+       name = g_utf8_strdown (val, nitems);
+     else if (reply->bytes_after > 0 && end > val)
+       name = g_utf8_strdown (val, end - val);
+   }
+
+  return name;
+}
+
 
-  panel_return_val_if_fail (XFCE_IS_SYSTRAY_SOCKET (socket), NULL);
-  panel_return_val_if_fail (type_name != NULL && prop_name != NULL, NULL);
+
+static void
+systray_socket_name_request (SystraySocket *socket)
+{
+  GdkDisplay       *display;
+  xcb_connection_t *connection;
+
+  systray_socket_name_discard (socket);
 
   display = gtk_widget_get_display (GTK_WIDGET (socket));
+  connection = XGetXCBConnection (GDK_DISPLAY_XDISPLAY (display));
 
-  req_type = gdk_x11_get_xatom_by_name_for_display (display, type_name);
+  /* try _NET_WM_NAME first, for gtk icon implementations, fall back to
+   * WM_NAME for qt icons */
+  socket->name_cookies[0] = xcb_get_property (connection, FALSE, socket->window,
+      gdk_x11_get_xatom_by_name_for_display (display, "_NET_WM_NAME"),
+      gdk_x11_get_xatom_by_name_for_display (display, "UTF8_STRING"),
+      0, NAME_MAX_LENGTH);
+  socket->name_cookies[1] = xcb_get_property (connection, FALSE, socket->window,
+      XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 0, NAME_MAX_LENGTH);
+
+  socket->name_pending = TRUE;
+}
 
-  gdk_error_trap_push ();
 
-  result = XGetWindowProperty (GDK_DISPLAY_XDISPLAY (display),
-                               socket->window,
-                               gdk_x11_get_xatom_by_name_for_display (display, prop_name),
-                               0, G_MAXLONG, False,
-                               req_type,
-                               &type, &format, &nitems,
-                               &bytes_after,
-                               (guchar **) &val);
 
-  /* check if everything went fine */
-  if (gdk_error_trap_pop () != 0
-      || result != Success
-      || val == NULL)
-    return NULL;
+static void
+systray_socket_name_discard (SystraySocket *socket)
+{
+  xcb_connection_t *connection;
 
-  /* check the returned data */
-  if (type == req_type
-      && format == 8
-      && nitems > 0
-      && g_utf8_validate (val, nitems, NULL))
-   {
-     /* lowercase the result */
-     name = g_utf8_strdown (val, nitems);
-   }
+  if (!socket->name_pending)
+    return;
 
-  XFree (val);
+  connection = XGetXCBConnection (GDK_DISPLAY_XDISPLAY (gtk_widget_get_display (GTK_WIDGET (socket))));
+  xcb_discard_reply (connection, socket->name_cookies[0].sequence);
+  xcb_discard_reply (connection, socket->name_cookies[1].sequence);
 
-  return name;
+  socket->name_pending = FALSE;
 }
 
 
@@ -391,16 +558,48 @@ systray_socket_get_name_prop (SystraySocket *socket,
 const gchar *
 systray_socket_get_name (SystraySocket *socket)
 {
+  GdkDisplay               *display;
+  xcb_connection_t         *connection;
+  xcb_get_property_reply_t *reply;
+  xcb_generic_error_t      *error;
+  guint                     i;
+  xcb_atom_t                req_types[2];
+
   panel_return_val_if_fail (XFCE_IS_SYSTRAY_SOCKET (socket), NULL);
 
-  if (G_LIKELY (socket->name != NULL))
+  /* also cache icons without a name, this is called a lot
+   * while sorting the icons in the box */
+  if (G_LIKELY (socket->name_valid))
     return socket->name;
 
-  /* try _NET_WM_NAME first, for gtk icon implementations, fall back to
-   * WM_NAME for qt icons */
-  socket->name = systray_socket_get_name_prop (socket, "_NET_WM_NAME", "UTF8_STRING");
-  if (G_UNLIKELY (socket->name == NULL))
-    socket->name = systray_socket_get_name_prop (socket, "WM_NAME", "STRING");
+  if (!socket->name_pending)
+    systray_socket_name_request (socket);
+
+  display = gtk_widget_get_display (GTK_WIDGET (socket));
+  connection = XGetXCBConnection (GDK_DISPLAY_XDISPLAY (display));
+  req_types[0] = gdk_x11_get_xatom_by_name_for_display (display, "UTF8_STRING");
+  req_types[1] = XCB_ATOM_STRING;
+
+  /* the requests were sent earlier, so their replies normally arrived
+   * already; errors are returned in the reply and ignored */
+  for (i = 0; i < G_N_ELEMENTS (req_types); i++)
+    {
+      if (socket->name == NULL)
+        {
+          error = NULL;
+          reply = xcb_get_property_reply (connection, socket->name_cookies[i], &error);
+          socket->name = systray_socket_get_name_prop (reply, req_types[i]);
+          free (reply);
+          free (error);
+        }
+      else
+        {
+          xcb_discard_reply (connection, socket->name_cookies[i].sequence);
+        }
+    }
+
+  socket->name_pending = FALSE;
+  socket->name_valid = TRUE;
 
   return socket->name;
 }
@@ -32,6 +32,8 @@
 #include "systray-box.h"
 #include "systray-socket.h"
 #include "systray-manager.h"
+#include "systray-sni-host.h"
+#include "systray-sni-item.h"
 #include "systray-dialog_ui.h"
 
 #define ICON_SIZE     (22)
@@ -49,6 +51,8 @@ static void     systray_plugin_set_property                 (GObject
                                                              GParamSpec            *pspec);
 static void     systray_plugin_construct                    (XfcePanelPlugin       *panel_plugin);
 static void     systray_plugin_free_data                    (XfcePanelPlugin       *panel_plugin);
+static void     systray_plugin_host_set_enabled             (SystrayPlugin         *plugin,
+                                                             gboolean               enabled);
 static void     systray_plugin_orientation_changed          (XfcePanelPlugin       *panel_plugin,
                                                              GtkOrientation         orientation);
 static gboolean systray_plugin_size_changed                 (XfcePanelPlugin       *panel_plugin,
@@ -80,6 +84,12 @@ static void     systray_plugin_icon_removed                 (SystrayManager
                                                              SystrayPlugin         *plugin);
 static void     systray_plugin_lost_selection               (SystrayManager        *manager,
                                                              SystrayPlugin         *plugin);
+static void     systray_plugin_item_added                   (SystraySniHost        *host,
+                                                             GtkWidget             *item,
+                                                             SystrayPlugin         *plugin);
+static void     systray_plugin_item_removed                 (SystraySniHost        *host,
+                                                             GtkWidget             *item,
+                                                             SystrayPlugin         *plugin);
 static void     systray_plugin_dialog_add_application_names (gpointer               key,
                                                              gpointer               value,
                                                              gpointer               user_data);
@@ -103,6 +113,9 @@ struct _SystrayPlugin
   /* systray manager */
   SystrayManager *manager;
 
+  /* status notifier items host */
+  SystraySniHost *host;
+
   guint           idle_startup;
 
   /* widgets */
@@ -122,7 +135,8 @@ enum
   PROP_SIZE_MAX,
   PROP_SHOW_FRAME,
   PROP_NAMES_HIDDEN,
-  PROP_NAMES_VISIBLE
+  PROP_NAMES_VISIBLE,
+  PROP_STATUS_NOTIFIER_ITEMS
 };
 
 enum
@@ -139,7 +153,9 @@ enum
 XFCE_PANEL_DEFINE_PLUGIN (SystrayPlugin, systray_plugin,
     systray_box_register_type,
     systray_manager_register_type,
-    systray_socket_register_type)
+    systray_socket_register_type,
+    systray_sni_host_register_type,
+    systray_sni_item_register_type)
 
 
 
@@ -204,6 +220,13 @@ systray_plugin_class_init (SystrayPluginClass *klass)
                                                        NULL, NULL,
                                                        PANEL_PROPERTIES_TYPE_VALUE_ARRAY,
                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+                                   PROP_STATUS_NOTIFIER_ITEMS,
+                                   g_param_spec_boolean ("status-notifier-items",
+                                                         NULL, NULL,
+                                                         FALSE,
+                                                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 
@@ -214,6 +237,7 @@ systray_plugin_init (SystrayPlugin *plugin)
   //GtkRcStyle *style;
 
   plugin->manager = NULL;
+  plugin->host = NULL;
   plugin->show_frame = TRUE;
   plugin->idle_startup = 0;
   plugin->names = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
@@ -287,6 +311,10 @@ systray_plugin_get_property (GObject    *object,
       xfconf_array_free (array);
       break;
 
+    case PROP_STATUS_NOTIFIER_ITEMS:
+      g_value_set_boolean (value, plugin->host != NULL);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -363,6 +391,10 @@ systray_plugin_set_property (GObject      *object,
       systray_plugin_names_update (plugin);
       break;
 
+    case PROP_STATUS_NOTIFIER_ITEMS:
+      systray_plugin_host_set_enabled (plugin, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -454,6 +486,7 @@ systray_plugin_construct (XfcePanelPlugin *panel_plugin)
     { "show-frame", G_TYPE_BOOLEAN },
     { "names-visible", PANEL_PROPERTIES_TYPE_VALUE_ARRAY },
     { "names-hidden", PANEL_PROPERTIES_TYPE_VALUE_ARRAY },
+    { "status-notifier-items", G_TYPE_BOOLEAN },
     { NULL }
   };
 
@@ -475,6 +508,32 @@ systray_plugin_construct (XfcePanelPlugin *panel_plugin)
 
 
 
+static void
+systray_plugin_host_set_enabled (SystrayPlugin *plugin,
+                                 gboolean       enabled)
+{
+  if ((plugin->host != NULL) == enabled)
+    return;
+
+  if (enabled)
+    {
+      /* show status notifier items next to the xembed icons */
+      plugin->host = systray_sni_host_new ();
+      g_signal_connect (G_OBJECT (plugin->host), "item-added",
+          G_CALLBACK (systray_plugin_item_added), plugin);
+      g_signal_connect (G_OBJECT (plugin->host), "item-removed",
+          G_CALLBACK (systray_plugin_item_removed), plugin);
+    }
+  else
+    {
+      /* the host removes its items from the box when disposed */
+      g_object_unref (G_OBJECT (plugin->host));
+      plugin->host = NULL;
+    }
+}
+
+
+
 static void
 systray_plugin_free_data (XfcePanelPlugin *panel_plugin)
 {
@@ -495,6 +554,12 @@ systray_plugin_free_data (XfcePanelPlugin *panel_plugin)
       systray_manager_unregister (plugin->manager);
       g_object_unref (G_OBJECT (plugin->manager));
     }
+
+  if (G_LIKELY (plugin->host != NULL))
+    {
+      g_signal_handlers_disconnect_by_data (G_OBJECT (plugin->host), plugin);
+      g_object_unref (G_OBJECT (plugin->host));
+    }
 }
 
 
@@ -578,6 +643,12 @@ systray_plugin_configure_plugin (XfcePanelPlugin *panel_plugin)
                           G_OBJECT (object), "active",
                           G_BINDING_SYNC_CREATE | G_BINDING_BIDIRECTIONAL);
 
+  object = gtk_builder_get_object (builder, "status-notifier-items");
+  panel_return_if_fail (GTK_IS_WIDGET (object));
+  g_object_bind_property (G_OBJECT (plugin), "status-notifier-items",
+                          G_OBJECT (object), "active",
+                          G_BINDING_SYNC_CREATE | G_BINDING_BIDIRECTIONAL);
+
   store = gtk_builder_get_object (builder, "applications-store");
   panel_return_if_fail (GTK_IS_LIST_STORE (store));
   g_hash_table_foreach (plugin->names,
@@ -606,6 +677,10 @@ systray_plugin_box_draw_icon (GtkWidget *child,
   cairo_t       *cr = user_data;
   GtkAllocation  alloc;
 
+  /* status notifier items draw themselves */
+  if (!XFCE_IS_SYSTRAY_SOCKET (child))
+    return;
+
   if (systray_socket_is_composited (XFCE_SYSTRAY_SOCKET (child)))
     {
       gtk_widget_get_allocation (child, &alloc);
@@ -613,7 +688,8 @@ systray_plugin_box_draw_icon (GtkWidget *child,
       /* skip hidden (see offscreen in box widget) icons */
       if (alloc.x > -1 && alloc.y > -1)
         {
-          // FIXME
+          /* gtk3 turns the damage of the composited child into an
+           * expose of the parent, so always paint the current contents */
           gdk_cairo_set_source_window (cr, gtk_widget_get_window (child),
                                        alloc.x, alloc.y);
           cairo_paint (cr);
@@ -729,16 +805,40 @@ static void
 systray_plugin_names_update_icon (GtkWidget *icon,
                                   gpointer   data)
 {
-  SystrayPlugin *plugin = XFCE_SYSTRAY_PLUGIN (data);
-  SystraySocket *socket = XFCE_SYSTRAY_SOCKET (icon);
-  const gchar   *name;
+  SystrayPlugin  *plugin = XFCE_SYSTRAY_PLUGIN (data);
+  SystraySniItem *item;
+  SystraySocket  *socket;
 
   panel_return_if_fail (XFCE_IS_SYSTRAY_PLUGIN (plugin));
-  panel_return_if_fail (XFCE_IS_SYSTRAY_SOCKET (icon));
 
-  name = systray_socket_get_name (socket);
-  systray_socket_set_hidden (socket,
-      systray_plugin_names_get_hidden (plugin, name));
+  if (XFCE_IS_SYSTRAY_SNI_ITEM (icon))
+    {
+      item = XFCE_SYSTRAY_SNI_ITEM (icon);
+      systray_sni_item_set_hidden (item,
+          systray_plugin_names_get_hidden (plugin, systray_sni_item_get_name (item)));
+    }
+  else
+    {
+      panel_return_if_fail (XFCE_IS_SYSTRAY_SOCKET (icon));
+
+      socket = XFCE_SYSTRAY_SOCKET (icon);
+      systray_socket_set_hidden (socket,
+          systray_plugin_names_get_hidden (plugin, systray_socket_get_name (socket)));
+    }
+}
+
+
+
+static void
+systray_plugin_icon_name_changed (GtkWidget     *icon,
+                                  SystrayPlugin *plugin)
+{
+  panel_return_if_fail (XFCE_IS_SYSTRAY_PLUGIN (plugin));
+
+  /* the new name was already requested by the icon, update the
+   * hidden state and the sort order of the icon */
+  systray_plugin_names_update_icon (icon, plugin);
+  systray_box_update (XFCE_SYSTRAY_BOX (plugin->box));
 }
 
 
@@ -830,6 +930,9 @@ systray_plugin_icon_added (SystrayManager *manager,
   gtk_container_add (GTK_CONTAINER (plugin->box), icon);
   gtk_widget_show (icon);
 
+  g_signal_connect (G_OBJECT (icon), "name-changed",
+      G_CALLBACK (systray_plugin_icon_name_changed), plugin);
+
   panel_debug_filtered (PANEL_DEBUG_SYSTRAY, "added %s[%p] icon",
       systray_socket_get_name (XFCE_SYSTRAY_SOCKET (icon)), icon);
 }
@@ -873,6 +976,46 @@ systray_plugin_lost_selection (SystrayManager *manager,
 
 
 
+static void
+systray_plugin_item_added (SystraySniHost *host,
+                           GtkWidget      *item,
+                           SystrayPlugin  *plugin)
+{
+  panel_return_if_fail (XFCE_IS_SYSTRAY_SNI_HOST (host));
+  panel_return_if_fail (XFCE_IS_SYSTRAY_PLUGIN (plugin));
+  panel_return_if_fail (XFCE_IS_SYSTRAY_SNI_ITEM (item));
+  panel_return_if_fail (plugin->host == host);
+
+  /* the item shows itself once its properties are loaded */
+  systray_plugin_names_update_icon (item, plugin);
+  gtk_container_add (GTK_CONTAINER (plugin->box), item);
+
+  /* the id of the item is the name used in the settings */
+  g_signal_connect (G_OBJECT (item), "name-changed",
+      G_CALLBACK (systray_plugin_icon_name_changed), plugin);
+}
+
+
+
+static void
+systray_plugin_item_removed (SystraySniHost *host,
+                             GtkWidget      *item,
+                             SystrayPlugin  *plugin)
+{
+  panel_return_if_fail (XFCE_IS_SYSTRAY_SNI_HOST (host));
+  panel_return_if_fail (XFCE_IS_SYSTRAY_PLUGIN (plugin));
+  panel_return_if_fail (plugin->host == host);
+
+  g_signal_handlers_disconnect_by_func (G_OBJECT (item),
+      systray_plugin_icon_name_changed, plugin);
+  gtk_container_remove (GTK_CONTAINER (plugin->box), item);
+
+  panel_debug_filtered (PANEL_DEBUG_SYSTRAY, "removed %s[%p] item",
+      systray_sni_item_get_name (XFCE_SYSTRAY_SNI_ITEM (item)), item);
+}
+
+
+
 static gchar *
 systray_plugin_dialog_camel_case (const gchar *text)
 {
@@ -38,6 +38,8 @@
 #define DEFAULT_ELLIPSIZE_MODE  (PANGO_ELLIPSIZE_MIDDLE)
 #define URGENT_FLAGS            (WNCK_WINDOW_STATE_DEMANDS_ATTENTION | \
                                  WNCK_WINDOW_STATE_URGENT)
+#define DECORATION_FLAGS        (WNCK_WINDOW_STATE_MINIMIZED | \
+                                 WNCK_WINDOW_STATE_SHADED)
 
 struct _WindowMenuPluginClass
 {
@@ -62,9 +64,17 @@ struct _WindowMenuPlugin
   guint               urgentcy_notification : 1;
   guint               all_workspaces : 1;
 
-  /* urgent window counter */
+  /* monitored windows and their urgency, and the urgent window counter */
+  GHashTable         *windows;
   gint                urgent_windows;
 
+  /* cached window menu items, reused between popups */
+  GHashTable         *items;
+
+  /* type-to-filter text and its header in the open menu */
+  GString            *filter;
+  GtkWidget          *filter_item;
+
   /* gtk style properties */
   gint                minimized_icon_lucency;
   PangoEllipsizeMode  ellipsize_mode;
@@ -87,6 +97,12 @@ enum
   BUTTON_STYLE_ARROW
 };
 
+enum
+{
+  WINDOW_STATE_NORMAL = 1,
+  WINDOW_STATE_URGENT
+};
+
 
 
 static void      window_menu_plugin_get_property            (GObject            *object,
@@ -127,6 +143,10 @@ static void      window_menu_plugin_window_closed           (WnckScreen
 static void      window_menu_plugin_windows_disconnect      (WindowMenuPlugin   *plugin);
 static void      window_menu_plugin_windows_connect         (WindowMenuPlugin   *plugin,
                                                              gboolean            traverse_windows);
+static void      window_menu_plugin_items_window_closed     (WnckScreen         *screen,
+                                                             WnckWindow         *window,
+                                                             WindowMenuPlugin   *plugin);
+static void      window_menu_plugin_item_free               (gpointer            data);
 static void      window_menu_plugin_menu                    (GtkWidget          *button,
                                                              WindowMenuPlugin   *plugin);
 
@@ -138,6 +158,7 @@ XFCE_PANEL_DEFINE_PLUGIN_RESIDENT (WindowMenuPlugin, window_menu_plugin)
 
 
 static GQuark window_quark = 0;
+static GQuark filter_quark = 0;
 
 
 
@@ -225,6 +246,7 @@ window_menu_plugin_class_init (WindowMenuPluginClass *klass)
                                                              G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
   window_quark = g_quark_from_static_string ("window-list-window-quark");
+  filter_quark = g_quark_from_static_string ("window-list-filter-quark");
 }
 
 
@@ -238,9 +260,13 @@ window_menu_plugin_init (WindowMenuPlugin *plugin)
   plugin->urgentcy_notification = TRUE;
   plugin->all_workspaces = TRUE;
   plugin->urgent_windows = 0;
+  plugin->windows = g_hash_table_new (g_direct_hash, g_direct_equal);
   plugin->minimized_icon_lucency = DEFAULT_ICON_LUCENCY;
   plugin->ellipsize_mode = DEFAULT_ELLIPSIZE_MODE;
   plugin->max_width_chars = DEFAULT_MAX_WIDTH_CHARS;
+  plugin->items = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                         NULL, window_menu_plugin_item_free);
+  plugin->filter = g_string_new (NULL);
 
   /* create the widgets */
   plugin->button = xfce_arrow_button_new (GTK_ARROW_NONE);
@@ -386,6 +412,10 @@ window_menu_plugin_style_set (GtkWidget *widget,
                         "ellipsize-mode", &plugin->ellipsize_mode,
                         "max-width-chars", &plugin->max_width_chars,
                         NULL);
+
+  /* the cached menu items use the old style properties */
+  if (plugin->items != NULL)
+    g_hash_table_remove_all (plugin->items);
 }
 
 
@@ -416,6 +446,11 @@ window_menu_plugin_screen_changed (GtkWidget *widget,
       /* disconnect from the previous screen */
       g_signal_handlers_disconnect_by_func (G_OBJECT (plugin->screen),
           window_menu_plugin_active_window_changed, plugin);
+      g_signal_handlers_disconnect_by_func (G_OBJECT (plugin->screen),
+          window_menu_plugin_items_window_closed, plugin);
+
+      /* drop the menu items of the old screen */
+      g_hash_table_remove_all (plugin->items);
     }
 
   /* set the new screen */
@@ -424,9 +459,12 @@ window_menu_plugin_screen_changed (GtkWidget *widget,
   /* connect signal to monitor this screen */
   g_signal_connect (G_OBJECT (plugin->screen), "active-window-changed",
       G_CALLBACK (window_menu_plugin_active_window_changed), plugin);
+  g_signal_connect (G_OBJECT (plugin->screen), "window-closed",
+      G_CALLBACK (window_menu_plugin_items_window_closed), plugin);
 
+  /* windows that are already monitored are skipped */
   if (plugin->urgentcy_notification)
-     window_menu_plugin_windows_connect (plugin, FALSE);
+     window_menu_plugin_windows_connect (plugin, TRUE);
 }
 
 
@@ -484,9 +522,17 @@ window_menu_plugin_free_data (XfcePanelPlugin *panel_plugin)
       /* disconnect from the screen */
       g_signal_handlers_disconnect_by_func (G_OBJECT (plugin->screen),
           window_menu_plugin_active_window_changed, plugin);
+      g_signal_handlers_disconnect_by_func (G_OBJECT (plugin->screen),
+          window_menu_plugin_items_window_closed, plugin);
 
       plugin->screen = NULL;
     }
+
+  g_hash_table_destroy (plugin->items);
+  plugin->items = NULL;
+
+  g_hash_table_destroy (plugin->windows);
+  g_string_free (plugin->filter, TRUE);
 }
 
 
@@ -672,6 +718,38 @@ window_menu_plugin_active_window_changed (WnckScreen       *screen,
 
 
 
+static void
+window_menu_plugin_window_set_urgent (WindowMenuPlugin *plugin,
+                                      WnckWindow       *window,
+                                      gboolean          urgent)
+{
+  gpointer state;
+
+  /* only count windows we monitor */
+  state = g_hash_table_lookup (plugin->windows, window);
+  if (state == NULL
+      || (GPOINTER_TO_UINT (state) == WINDOW_STATE_URGENT) == !!urgent)
+    return;
+
+  g_hash_table_insert (plugin->windows, window,
+      GUINT_TO_POINTER (urgent ? WINDOW_STATE_URGENT : WINDOW_STATE_NORMAL));
+
+  /* update the counter and only change the button if it crossed zero */
+  if (urgent)
+    {
+      if (++plugin->urgent_windows == 1)
+        xfce_arrow_button_set_blinking (XFCE_ARROW_BUTTON (plugin->button), TRUE);
+    }
+  else
+    {
+      panel_return_if_fail (plugin->urgent_windows > 0);
+      if (--plugin->urgent_windows == 0)
+        xfce_arrow_button_set_blinking (XFCE_ARROW_BUTTON (plugin->button), FALSE);
+    }
+}
+
+
+
 static void
 window_menu_plugin_window_state_changed (WnckWindow       *window,
                                          WnckWindowState   changed_mask,
@@ -681,23 +759,13 @@ window_menu_plugin_window_state_changed (WnckWindow       *window,
   panel_return_if_fail (XFCE_IS_WINDOW_MENU_PLUGIN (plugin));
   panel_return_if_fail (WNCK_IS_WINDOW (window));
   panel_return_if_fail (plugin->urgentcy_notification);
-  panel_return_if_fail (plugin->urgentcy_notification);
 
   /* only response to urgency changes and urgency notify is enabled */
   if (!PANEL_HAS_FLAG (changed_mask, URGENT_FLAGS))
     return;
 
-  /* update the blinking state */
-  if (PANEL_HAS_FLAG (new_state, URGENT_FLAGS))
-    plugin->urgent_windows++;
-  else
-    plugin->urgent_windows--;
-
-  /* check if we need to change the button */
-  if (plugin->urgent_windows == 1)
-    xfce_arrow_button_set_blinking (XFCE_ARROW_BUTTON (plugin->button), TRUE);
-  else if (plugin->urgent_windows == 0)
-    xfce_arrow_button_set_blinking (XFCE_ARROW_BUTTON (plugin->button), FALSE);
+  window_menu_plugin_window_set_urgent (plugin, window,
+      PANEL_HAS_FLAG (new_state, URGENT_FLAGS));
 }
 
 
@@ -713,14 +781,19 @@ window_menu_plugin_window_opened (WnckScreen       *screen,
   panel_return_if_fail (plugin->screen == screen);
   panel_return_if_fail (plugin->urgentcy_notification);
 
+  /* leave if the window is already monitored */
+  if (g_hash_table_lookup (plugin->windows, window) != NULL)
+    return;
+
   /* monitor the window's state */
+  g_hash_table_insert (plugin->windows, window,
+                       GUINT_TO_POINTER (WINDOW_STATE_NORMAL));
   g_signal_connect (G_OBJECT (window), "state-changed",
       G_CALLBACK (window_menu_plugin_window_state_changed), plugin);
 
   /* check if the window needs attention */
   if (wnck_window_needs_attention (window))
-    window_menu_plugin_window_state_changed (window, URGENT_FLAGS,
-                                             URGENT_FLAGS, plugin);
+    window_menu_plugin_window_set_urgent (plugin, window, TRUE);
 }
 
 
@@ -736,10 +809,12 @@ window_menu_plugin_window_closed (WnckScreen       *screen,
   panel_return_if_fail (plugin->screen == screen);
   panel_return_if_fail (plugin->urgentcy_notification);
 
-  /* check if we need to update the urgency counter */
-  if (wnck_window_needs_attention (window))
-    window_menu_plugin_window_state_changed (window, URGENT_FLAGS,
-                                             0, plugin);
+  /* update the urgency counter with the state we counted */
+  window_menu_plugin_window_set_urgent (plugin, window, FALSE);
+
+  if (g_hash_table_remove (plugin->windows, window))
+    g_signal_handlers_disconnect_by_func (G_OBJECT (window),
+        window_menu_plugin_window_state_changed, plugin);
 }
 
 
@@ -747,7 +822,8 @@ window_menu_plugin_window_closed (WnckScreen       *screen,
 static void
 window_menu_plugin_windows_disconnect (WindowMenuPlugin *plugin)
 {
-  GList *windows, *li;
+  GHashTableIter iter;
+  gpointer       window;
 
   panel_return_if_fail (XFCE_IS_WINDOW_MENU_PLUGIN (plugin));
   panel_return_if_fail (WNCK_IS_SCREEN (plugin->screen));
@@ -758,14 +834,15 @@ window_menu_plugin_windows_disconnect (WindowMenuPlugin *plugin)
   g_signal_handlers_disconnect_by_func (G_OBJECT (plugin->screen),
      window_menu_plugin_window_opened, plugin);
 
-  /* disconnect the state changed signal from all windows */
-  windows = wnck_screen_get_windows (plugin->screen);
-  for (li = windows; li != NULL; li = li->next)
+  /* disconnect the state changed signal from the monitored windows */
+  g_hash_table_iter_init (&iter, plugin->windows);
+  while (g_hash_table_iter_next (&iter, &window, NULL))
     {
-      panel_return_if_fail (WNCK_IS_WINDOW (li->data));
-      g_signal_handlers_disconnect_by_func (G_OBJECT (li->data),
+      panel_return_if_fail (WNCK_IS_WINDOW (window));
+      g_signal_handlers_disconnect_by_func (G_OBJECT (window),
           window_menu_plugin_window_state_changed, plugin);
     }
+  g_hash_table_remove_all (plugin->windows);
 
   /* stop blinking */
   plugin->urgent_windows = 0;
@@ -792,7 +869,9 @@ window_menu_plugin_windows_connect (WindowMenuPlugin *plugin,
   if (!traverse_windows)
     return;
 
-  /* connect the state changed signal to all windows */
+  /* connect the state changed signal to all windows, this only
+   * happens when the setting is enabled, after that the counter
+   * is updated from the window events */
   windows = wnck_screen_get_windows (plugin->screen);
   for (li = windows; li != NULL; li = li->next)
     {
@@ -955,18 +1034,18 @@ window_menu_plugin_menu_window_item_activate (GtkWidget      *mi,
 
 
 static GtkWidget *
-window_menu_plugin_menu_window_item_new (WnckWindow           *window,
-                                         WindowMenuPlugin     *plugin,
-                                         PangoFontDescription *italic,
-                                         PangoFontDescription *bold,
-                                         gint                  icon_w,
-                                         gint                  icon_h)
+window_menu_plugin_menu_window_item_new (WnckWindow       *window,
+                                         WindowMenuPlugin *plugin,
+                                         gint              icon_w,
+                                         gint              icon_h)
 {
-  const gchar *name, *tooltip;
-  gchar       *utf8 = NULL;
-  gchar       *decorated = NULL;
-  GtkWidget   *mi, *label, *image;
-  GdkPixbuf   *pixbuf, *lucent = NULL, *scaled = NULL;
+  const gchar    *name, *tooltip;
+  gchar          *utf8 = NULL;
+  gchar          *decorated = NULL;
+  gchar          *text;
+  GtkWidget      *mi, *label, *image;
+  GdkPixbuf      *pixbuf, *lucent = NULL, *scaled = NULL;
+  WnckClassGroup *class_group;
 
   panel_return_val_if_fail (WNCK_IS_WINDOW (window), NULL);
 
@@ -996,6 +1075,17 @@ G_GNUC_END_IGNORE_DEPRECATIONS
   g_signal_connect (G_OBJECT (mi), "button-release-event",
       G_CALLBACK (window_menu_plugin_menu_window_item_activate), window);
 
+  /* store the casefolded title and class for filtering, the item is
+   * recreated when the name changes, so this stays up-to-date */
+  class_group = wnck_window_get_class_group (window);
+  if (class_group != NULL)
+    text = g_strconcat (tooltip, "\n", wnck_class_group_get_name (class_group), NULL);
+  else
+    text = g_strdup (tooltip);
+  g_object_set_qdata_full (G_OBJECT (mi), filter_quark,
+                           g_utf8_casefold (text, -1), g_free);
+  g_free (text);
+
   g_free (utf8);
   g_free (decorated);
 
@@ -1005,12 +1095,6 @@ G_GNUC_END_IGNORE_DEPRECATIONS
   gtk_label_set_ellipsize (GTK_LABEL (label), plugin->ellipsize_mode);
   gtk_label_set_max_width_chars (GTK_LABEL (label), plugin->max_width_chars);
 
-  /* modify the label font if needed */
-  if (wnck_window_is_active (window))
-    gtk_widget_modify_font (label, italic);
-  else if (wnck_window_or_transient_needs_attention (window))
-    gtk_widget_modify_font (label, bold);
-
   if (plugin->minimized_icon_lucency > 0)
     {
       /* get the window icon */
@@ -1061,6 +1145,140 @@ G_GNUC_END_IGNORE_DEPRECATIONS
 
 
 
+static void
+window_menu_plugin_item_free (gpointer data)
+{
+  GtkWidget  *mi = GTK_WIDGET (data);
+  WnckWindow *window;
+
+  window = g_object_get_qdata (G_OBJECT (mi), window_quark);
+  panel_return_if_fail (WNCK_IS_WINDOW (window));
+
+  g_signal_handlers_disconnect_matched (G_OBJECT (window), G_SIGNAL_MATCH_DATA,
+                                        0, 0, NULL, NULL, mi);
+
+  /* the item might still be shown in an open menu */
+  g_object_unref (G_OBJECT (mi));
+}
+
+
+
+static void
+window_menu_plugin_item_window_changed (WnckWindow *window,
+                                        GtkWidget  *mi)
+{
+  WindowMenuPlugin *plugin;
+
+  plugin = g_object_get_data (G_OBJECT (mi), "window-menu-plugin");
+  panel_return_if_fail (XFCE_IS_WINDOW_MENU_PLUGIN (plugin));
+
+  /* the item is created again on the next popup */
+  g_hash_table_remove (plugin->items, window);
+}
+
+
+
+static void
+window_menu_plugin_item_window_state_changed (WnckWindow      *window,
+                                              WnckWindowState  changed_mask,
+                                              WnckWindowState  new_state,
+                                              GtkWidget       *mi)
+{
+  /* urgency and activity only change the font, which is updated
+   * on every popup, so only rebuild the label and icon if needed */
+  if (PANEL_HAS_FLAG (changed_mask, DECORATION_FLAGS))
+    window_menu_plugin_item_window_changed (window, mi);
+}
+
+
+
+static void
+window_menu_plugin_items_window_closed (WnckScreen       *screen,
+                                        WnckWindow       *window,
+                                        WindowMenuPlugin *plugin)
+{
+  panel_return_if_fail (XFCE_IS_WINDOW_MENU_PLUGIN (plugin));
+  panel_return_if_fail (plugin->screen == screen);
+
+  g_hash_table_remove (plugin->items, window);
+}
+
+
+
+static GtkWidget *
+window_menu_plugin_menu_window_item_get (WnckWindow           *window,
+                                         WindowMenuPlugin     *plugin,
+                                         PangoFontDescription *italic,
+                                         PangoFontDescription *bold,
+                                         gint                  icon_w,
+                                         gint                  icon_h)
+{
+  GtkWidget *mi;
+  GtkWidget *label;
+
+  panel_return_val_if_fail (WNCK_IS_WINDOW (window), NULL);
+  panel_return_val_if_fail (XFCE_IS_WINDOW_MENU_PLUGIN (plugin), NULL);
+
+  /* only create a new item if the window changed since the last popup */
+  mi = g_hash_table_lookup (plugin->items, window);
+  if (mi == NULL)
+    {
+      mi = window_menu_plugin_menu_window_item_new (window, plugin, icon_w, icon_h);
+      g_object_ref_sink (G_OBJECT (mi));
+      g_object_set_data (G_OBJECT (mi), "window-menu-plugin", plugin);
+      g_hash_table_insert (plugin->items, window, mi);
+
+      g_signal_connect (G_OBJECT (window), "name-changed",
+          G_CALLBACK (window_menu_plugin_item_window_changed), mi);
+      g_signal_connect (G_OBJECT (window), "icon-changed",
+          G_CALLBACK (window_menu_plugin_item_window_changed), mi);
+      g_signal_connect (G_OBJECT (window), "state-changed",
+          G_CALLBACK (window_menu_plugin_item_window_state_changed), mi);
+    }
+
+  /* modify the label font if needed */
+  label = gtk_bin_get_child (GTK_BIN (mi));
+  panel_return_val_if_fail (GTK_IS_LABEL (label), NULL);
+  if (wnck_window_is_active (window))
+    gtk_widget_modify_font (label, italic);
+  else if (wnck_window_or_transient_needs_attention (window))
+    gtk_widget_modify_font (label, bold);
+  else
+    gtk_widget_modify_font (label, NULL);
+
+  return mi;
+}
+
+
+
+static void
+window_menu_plugin_menu_destroyed (GtkWidget        *menu,
+                                   WindowMenuPlugin *plugin)
+{
+  GList      *children, *li;
+  WnckWindow *window;
+
+  panel_return_if_fail (XFCE_IS_WINDOW_MENU_PLUGIN (plugin));
+
+  plugin->filter_item = NULL;
+
+  if (plugin->items == NULL)
+    return;
+
+  /* take the cached items out of the menu, so they survive the menu */
+  children = gtk_container_get_children (GTK_CONTAINER (menu));
+  for (li = children; li != NULL; li = li->next)
+    {
+      window = g_object_get_qdata (G_OBJECT (li->data), window_quark);
+      if (window != NULL
+          && g_hash_table_lookup (plugin->items, window) == li->data)
+        gtk_container_remove (GTK_CONTAINER (menu), GTK_WIDGET (li->data));
+    }
+  g_list_free (children);
+}
+
+
+
 static void
 window_menu_plugin_menu_selection_done (GtkWidget *menu,
                                         GtkWidget *button)
@@ -1077,9 +1295,133 @@ window_menu_plugin_menu_selection_done (GtkWidget *menu,
 
 
 
+static void
+window_menu_plugin_menu_filter (GtkWidget        *menu,
+                                WindowMenuPlugin *plugin)
+{
+  GList       *children, *li;
+  GtkWidget   *first = NULL;
+  gchar       *needle, *label;
+  const gchar *text;
+  gboolean     visible;
+
+  panel_return_if_fail (GTK_IS_MENU (menu));
+  panel_return_if_fail (GTK_IS_MENU_ITEM (plugin->filter_item));
+
+  if (plugin->filter->len > 0)
+    {
+      label = g_strdup_printf (_("Search: %s"), plugin->filter->str);
+      gtk_menu_item_set_label (GTK_MENU_ITEM (plugin->filter_item), label);
+      gtk_widget_show (plugin->filter_item);
+      g_free (label);
+
+      needle = g_utf8_casefold (plugin->filter->str, -1);
+    }
+  else
+    {
+      gtk_widget_hide (plugin->filter_item);
+      needle = NULL;
+    }
+
+  /* only show the window items that match the filter, other items
+   * are hidden while filtering */
+  children = gtk_container_get_children (GTK_CONTAINER (menu));
+  for (li = children; li != NULL; li = li->next)
+    {
+      if (li->data == plugin->filter_item)
+        continue;
+
+      if (needle != NULL)
+        {
+          text = g_object_get_qdata (G_OBJECT (li->data), filter_quark);
+          visible = text != NULL && strstr (text, needle) != NULL;
+        }
+      else
+        {
+          visible = TRUE;
+        }
+
+      gtk_widget_set_visible (GTK_WIDGET (li->data), visible);
+
+      if (visible && first == NULL && needle != NULL)
+        first = GTK_WIDGET (li->data);
+    }
+  g_list_free (children);
+  g_free (needle);
+
+  /* select the first match, so return activates it */
+  if (first != NULL)
+    gtk_menu_shell_select_item (GTK_MENU_SHELL (menu), first);
+  else
+    gtk_menu_shell_deselect (GTK_MENU_SHELL (menu));
+}
+
+
+
+static gboolean
+window_menu_plugin_menu_filter_key (GtkWidget        *menu,
+                                    GdkEventKey      *event,
+                                    WindowMenuPlugin *plugin)
+{
+  gunichar     c;
+  const gchar *prev;
+
+  if (plugin->filter_item == NULL)
+    return FALSE;
+
+  /* leave shortcuts to the menu */
+  if ((event->state & gtk_accelerator_get_default_mod_mask () & ~GDK_SHIFT_MASK) != 0)
+    return FALSE;
+
+  switch (event->keyval)
+    {
+    case GDK_KEY_BackSpace:
+      if (plugin->filter->len == 0)
+        return FALSE;
+
+      /* remove the last character */
+      prev = g_utf8_find_prev_char (plugin->filter->str,
+                                    plugin->filter->str + plugin->filter->len);
+      g_string_truncate (plugin->filter, prev - plugin->filter->str);
+      break;
+
+    case GDK_KEY_Escape:
+      /* clear the filter first, the next escape closes the menu */
+      if (plugin->filter->len == 0)
+        return FALSE;
+
+      g_string_truncate (plugin->filter, 0);
+      break;
+
+    case GDK_KEY_space:
+    case GDK_KEY_KP_Space:
+      /* space activates the item unless we're typing */
+      if (plugin->filter->len == 0)
+        return FALSE;
+
+      g_string_append_c (plugin->filter, ' ');
+      break;
+
+    default:
+      c = gdk_keyval_to_unicode (event->keyval);
+      if (c == 0 || !g_unichar_isprint (c))
+        return FALSE;
+
+      g_string_append_unichar (plugin->filter, c);
+      break;
+    }
+
+  window_menu_plugin_menu_filter (menu, plugin);
+
+  return TRUE;
+}
+
+
+
 static gboolean
-window_menu_plugin_menu_key_press_event (GtkWidget   *menu,
-                                         GdkEventKey *event)
+window_menu_plugin_menu_key_press_event (GtkWidget        *menu,
+                                         GdkEventKey      *event,
+                                         WindowMenuPlugin *plugin)
 {
   GtkWidget      *mi = NULL;
   GdkEventButton  fake_event = { 0, };
@@ -1087,6 +1429,11 @@ window_menu_plugin_menu_key_press_event (GtkWidget   *menu,
   WnckWindow     *window;
 
   panel_return_val_if_fail (GTK_IS_MENU (menu), FALSE);
+  panel_return_val_if_fail (XFCE_IS_WINDOW_MENU_PLUGIN (plugin), FALSE);
+
+  /* typed text filters the windows in the menu */
+  if (window_menu_plugin_menu_filter_key (menu, event, plugin))
+    return TRUE;
 
   /* construct an event */
   switch (event->keyval)
@@ -1173,6 +1520,14 @@ window_menu_plugin_menu_new (WindowMenuPlugin *plugin)
   menu = gtk_menu_new ();
   g_signal_connect (G_OBJECT (menu), "key-press-event",
       G_CALLBACK (window_menu_plugin_menu_key_press_event), plugin);
+  g_signal_connect (G_OBJECT (menu), "destroy",
+      G_CALLBACK (window_menu_plugin_menu_destroyed), plugin);
+
+  /* header that shows the filter text, hidden until the user types */
+  g_string_truncate (plugin->filter, 0);
+  plugin->filter_item = gtk_menu_item_new_with_label ("");
+  gtk_menu_shell_append (GTK_MENU_SHELL (menu), plugin->filter_item);
+  gtk_widget_set_sensitive (plugin->filter_item, FALSE);
 
   /* get all the windows and the active workspace */
   windows = wnck_screen_get_windows_stacked (plugin->screen);
@@ -1231,7 +1586,7 @@ window_menu_plugin_menu_new (WindowMenuPlugin *plugin)
             continue;
 
           /* create the menu item */
-          mi = window_menu_plugin_menu_window_item_new (window, plugin, italic, bold, w, h);
+          mi = window_menu_plugin_menu_window_item_get (window, plugin, italic, bold, w, h);
           gtk_menu_shell_append (GTK_MENU_SHELL (menu), mi);
           gtk_widget_show (mi);
 
@@ -1306,7 +1661,7 @@ window_menu_plugin_menu_new (WindowMenuPlugin *plugin)
             continue;
 
           /* create the menu item */
-          mi = window_menu_plugin_menu_window_item_new (window, plugin, italic, bold, w, h);
+          mi = window_menu_plugin_menu_window_item_get (window, plugin, italic, bold, w, h);
           gtk_menu_shell_append (GTK_MENU_SHELL (menu), mi);
           gtk_widget_show (mi);
         }
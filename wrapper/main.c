@@ -155,6 +155,11 @@ wrapper_gproxy_set (DBusGProxy              *dbus_gproxy,
           xfce_panel_plugin_provider_ask_remove (provider);
           break;
 
+        case PROVIDER_PROP_TYPE_SET_BACKGROUND_CACHE:
+          plug = g_object_get_qdata (G_OBJECT (provider), plug_quark);
+          wrapper_plug_set_background_cache (plug, g_value_get_string (value));
+          break;
+
         default:
           panel_assert_not_reached ();
           break;
@@ -38,6 +38,7 @@ static gboolean wrapper_plug_expose_event     (GtkWidget      *widget,
                                                GdkEventExpose *event);
 #endif
 static void     wrapper_plug_background_reset (WrapperPlug    *plug);
+static cairo_pattern_t *wrapper_plug_background_map (const gchar *filename);
 
 
 
@@ -351,6 +352,48 @@ wrapper_plug_background_reset (WrapperPlug *plug)
 
 
 
+static cairo_pattern_t *
+wrapper_plug_background_map (const gchar *filename)
+{
+  static cairo_user_data_key_t  mapped_key;
+  GMappedFile                  *mapped;
+  const guint32                *header;
+  gsize                         length;
+  cairo_surface_t              *surface;
+  cairo_pattern_t              *pattern;
+
+  mapped = g_mapped_file_new (filename, FALSE, NULL);
+  if (G_UNLIKELY (mapped == NULL))
+    return NULL;
+
+  header = (const guint32 *) g_mapped_file_get_contents (mapped);
+  length = g_mapped_file_get_length (mapped);
+  if (length < PANEL_BACKGROUND_CACHE_HEADER
+      || header[0] != PANEL_BACKGROUND_CACHE_MAGIC
+      || (gint) header[3] != cairo_format_stride_for_width (CAIRO_FORMAT_ARGB32, header[1])
+      || length < PANEL_BACKGROUND_CACHE_HEADER + (gsize) header[2] * header[3])
+    {
+      g_mapped_file_unref (mapped);
+      return NULL;
+    }
+
+  /* use the pixels in the mapping directly, the surface keeps the
+   * mapping alive and is only used as source */
+  surface = cairo_image_surface_create_for_data (
+      (guchar *) g_mapped_file_get_contents (mapped) + PANEL_BACKGROUND_CACHE_HEADER,
+      CAIRO_FORMAT_ARGB32, header[1], header[2], header[3]);
+  cairo_surface_set_user_data (surface, &mapped_key, mapped,
+                               (cairo_destroy_func_t) g_mapped_file_unref);
+
+  pattern = cairo_pattern_create_for_surface (surface);
+  cairo_pattern_set_extend (pattern, CAIRO_EXTEND_REPEAT);
+  cairo_surface_destroy (surface);
+
+  return pattern;
+}
+
+
+
 WrapperPlug *
 #if GTK_CHECK_VERSION (3, 0, 0)
 wrapper_plug_new (Window socket_id)
@@ -432,3 +475,29 @@ wrapper_plug_set_background_image (WrapperPlug *plug,
 
   gtk_widget_queue_draw (GTK_WIDGET (plug));
 }
+
+
+
+void
+wrapper_plug_set_background_cache (WrapperPlug *plug,
+                                   const gchar *filename)
+{
+  cairo_pattern_t *pattern;
+
+  panel_return_if_fail (WRAPPER_IS_PLUG (plug));
+
+  /* the decoded image is always sent after the image itself */
+  if (plug->background_image == NULL || filename == NULL)
+    return;
+
+  /* keep decoding the image if the panel's copy cannot be mapped */
+  pattern = wrapper_plug_background_map (filename);
+  if (G_UNLIKELY (pattern == NULL))
+    return;
+
+  if (plug->background_image_cache != NULL)
+    cairo_pattern_destroy (plug->background_image_cache);
+  plug->background_image_cache = pattern;
+
+  gtk_widget_queue_draw (GTK_WIDGET (plug));
+}
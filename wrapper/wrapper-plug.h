@@ -60,6 +60,9 @@ void          wrapper_plug_set_background_color (WrapperPlug     *plug,
 void          wrapper_plug_set_background_image (WrapperPlug     *plug,
                                                  const gchar     *image);
 
+void          wrapper_plug_set_background_cache (WrapperPlug     *plug,
+                                                 const gchar     *filename);
+
 G_END_DECLS
 
 #endif /* !__WRAPPER_PLUG_H__ */